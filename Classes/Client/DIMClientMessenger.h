@@ -36,6 +36,7 @@
 //
 
 #import <DIMClient/DIMCommonMessenger.h>
+#import <DIMClient/DIMOutbox.h>
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -44,6 +45,13 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @interface DIMClientMessenger : DIMCommonMessenger
 
+/**
+ *  Messages packed before handshake accepted,
+ *  they will be sent out when the session is running;
+ *  hand it over to the new messenger when switching stations
+ */
+@property(nonatomic, strong) DIMOutbox *outbox;
+
 /**
  *  Send handshake command to current station
  *
@@ -52,7 +60,16 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)handshake:(nullable NSString *)sessionKey;
 
 /**
- *  Callback for handshake success
+ *  Frame formats advertised while handshaking
+ *
+ *  Override it to return nil for keeping JSON lines only.
+ */
+// protected
+- (nullable NSArray<NSString *> *)supportedFraming;
+
+/**
+ *  Callback for handshake success,
+ *  send out the messages held in the outbox
  */
 - (void)handshakeSuccess;
 
@@ -56,6 +56,16 @@
 
 @implementation DIMClientMessenger
 
+// Override
+- (instancetype)initWithFacebook:(DIMCommonFacebook *)barrack
+                         session:(id<DIMSession>)session
+                        database:(id<DIMCipherKeyDelegate>)db {
+    if (self = [super initWithFacebook:barrack session:session database:db]) {
+        self.outbox = [[DIMOutbox alloc] init];
+    }
+    return self;
+}
+
 // Override
 - (id<DKDReliableMessage>)sendInstantMessage:(id<DKDInstantMessage>)iMsg
                                     priority:(NSInteger)prior {
@@ -65,18 +75,12 @@
     } else {
         // not login yet
         __kindof id<DKDContent> content = [iMsg content];
-        if (![content conformsToProtocol:@protocol(DKDCommand)]) {
-            NSLog(@"not handshake yet, suspend message: %@ => %@", content, iMsg.receiver);
-            // TODO: suspend instant message
-            return nil;
-        } else if ([[content cmd] isEqualToString:DKDCommand_Handshake]) {
+        if ([content conformsToProtocol:@protocol(DKDCommand)] &&
+            [[content cmd] isEqualToString:DKDCommand_Handshake]) {
             // NOTICE: only handshake message can go out
             [iMsg setObject:@"handshaking" forKey:@"pass"];
-        } else {
-            NSLog(@"not handshake yet, drop command: %@ => %@", content, iMsg.receiver);
-            // TODO: suspend instant message
-            return nil;
         }
+        // other messages will be packed and held in the outbox
     }
     return [super sendInstantMessage:iMsg priority:prior];
 }
@@ -95,20 +99,59 @@
         // not login in yet, let the handshake message go out only
     } else {
         NSLog(@"not handshake yet, suspend message: %@ => %@", rMsg.sender, rMsg.receiver);
-        // TODO: suspend reliable message
-        return NO;
+        NSData *data = [self serializeMessage:rMsg];
+        [_outbox holdMessage:rMsg package:data priority:prior];
+        return YES;
     }
     return [super sendReliableMessage:rMsg priority:prior];
 }
 
+// Override
+- (NSUInteger)sendReliableMessages:(NSArray<id<DKDReliableMessage>> *)messages
+                          packages:(NSArray<NSData *> *)packages
+                          priority:(NSInteger)prior {
+    DIMClientSession *session = [self session];
+    if (![session isReady]) {
+        NSLog(@"not handshake yet, suspend %lu message(s)", [messages count]);
+        NSUInteger count = [messages count];
+        for (NSUInteger index = 0; index < count; ++index) {
+            [_outbox holdMessage:[messages objectAtIndex:index]
+                         package:[packages objectAtIndex:index]
+                        priority:prior];
+        }
+        return count;
+    }
+    return [super sendReliableMessages:messages packages:packages priority:prior];
+}
+
+// Override
+- (BOOL)checkEnvelope:(DIMLazyEnvelope *)env package:(NSData *)data {
+    id<MKMID> receiver = [env receiverID];
+    if (!receiver) {
+        NSLog(@"receiver error: %@", env.receiver);
+        return NO;
+    } else if ([receiver isBroadcast] || [receiver isGroup]) {
+        // check it after decrypted
+        return YES;
+    }
+    // the receiver can be any of the local users
+    DIMCommonFacebook *facebook = [self facebook];
+    if ([facebook currentUser] && ![facebook selectLocalUserForID:receiver]) {
+        NSLog(@"misrouted message: %@ => %@", env.sender, receiver);
+        return NO;
+    }
+    return [super checkEnvelope:env package:data];
+}
+
 - (void)handshake:(NSString *)sessionKey {
     DIMClientSession *session = [self session];
     id<MKMStation> station = [session station];
     id<MKMID> sid = [station identifier];
-    id<DKDContent> cmd;
+    DIMHandshakeCommand *cmd;
     if (sessionKey) {
         // handshake again
         cmd = [[DIMHandshakeCommand alloc] initWithSessionKey:sessionKey];
+        [cmd setFraming:[self supportedFraming]];
         [self sendContent:cmd
                    sender:nil
                  receiver:sid
@@ -124,6 +167,7 @@
         id<MKMVisa> visa = [DIMDocumentUtils lastVisa:[user documents]];
         id<DKDEnvelope> env = DKDEnvelopeCreate(uid, sid, nil);
         cmd = [[DIMHandshakeCommand alloc] initWithSessionKey:nil];
+        [cmd setFraming:[self supportedFraming]];
         // send first handshake command as broadcast message
         [cmd setGroup:MKMEveryStations];
         // create instant message with meta & visa
@@ -136,11 +180,44 @@
     }
 }
 
+- (nullable NSArray<NSString *> *)supportedFraming {
+    return @[DKDHandshakeFraming_Binary, DKDHandshakeFraming_Lines];
+}
+
 - (void)handshakeSuccess {
+    // send out the messages held before handshake accepted
+    [self flushOutbox];
     // broadcast current documents after handshake success
     [self broadcastDocument:NO];
 }
 
+// private
+- (void)flushOutbox {
+    NSArray<DIMOutboxItem *> *items = [_outbox removeAllItems:OKGetCurrentTimeInterval()];
+    NSUInteger count = [items count];
+    if (count == 0) {
+        return;
+    }
+    NSLog(@"sending %lu message(s) held in outbox", count);
+    // queue the messages with the same priority in one batch
+    NSMutableArray<id<DKDReliableMessage>> *messages = [[NSMutableArray alloc] init];
+    NSMutableArray<NSData *> *packages = [[NSMutableArray alloc] init];
+    DIMOutboxItem *item;
+    NSInteger prior;
+    for (NSUInteger index = 0; index < count; ++index) {
+        item = [items objectAtIndex:index];
+        prior = [item priority];
+        [messages addObject:[item message]];
+        [packages addObject:[item package]];
+        if (index + 1 < count && [[items objectAtIndex:(index + 1)] priority] == prior) {
+            continue;
+        }
+        [super sendReliableMessages:messages packages:packages priority:prior];
+        [messages removeAllObjects];
+        [packages removeAllObjects];
+    }
+}
+
 - (void)broadcastDocument:(BOOL)updated {
     DIMCommonFacebook *facebook = [self facebook];
     id<MKMUser> user = [facebook currentUser];
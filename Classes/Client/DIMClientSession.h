@@ -36,6 +36,8 @@
 //
 
 #import <DIMClient/DIMBaseSession.h>
+#import <DIMClient/DIMReconnectScheduler.h>
+#import <DIMClient/DIMDuplicateFilter.h>
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -48,15 +50,56 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property(nonatomic, readonly, nullable) DIMSessionState *state;
 
+// backoff for reconnecting after connection lost
+@property(nonatomic, readonly) DIMReconnectScheduler *reconnector;
+
+/**
+ *  Signatures of received messages,
+ *  for dropping the pushed again ones before verifying & decrypting
+ */
+@property(nonatomic, strong, nullable) DIMDuplicateFilter *duplicateFilter;
+
+/**
+ *  Serial queues for verifying & decrypting received packages
+ *  (default: none, process them on the gate thread one by one);
+ *  packages from the same conversation always go to the same lane.
+ *
+ *  Each lane has its own packer & processor created by the messenger,
+ *  the shared key cache, checkers & current user are locked.
+ *
+ *  NOTICE: customized processors, databases & delegates must be safe
+ *          to be called from several threads at the same time.
+ */
+@property(nonatomic, strong) NSArray<dispatch_queue_t> *inboundLanes;
+
+/**
+ *  Create lanes for processing received packages in parallel
+ *
+ * @param count - lanes count, e.g.: active processor count
+ * @return serial queues
+ */
++ (NSArray<dispatch_queue_t> *)createInboundLanes:(NSUInteger)count;
+
 // session key
 - (void)setSessionKey:(nullable NSString *)key;
 
+/**
+ *  Session key of the lost connection, it will be erased after fetched,
+ *  so if resuming with it failed, a full handshake will be done next time
+ *
+ * @return session key for handshaking again
+ */
+- (nullable NSString *)fetchResumableKey;
+
 - (BOOL)isReady;
 
 - (instancetype)initWithDatabase:(id<DIMSessionDBI>)db station:(id<MKMStation>)server;
 
 - (void)startWithStateDelegate:(id<DIMSessionStateDelegate>) delegate;
 
+// hand over state callbacks, e.g.: from station racer to terminal
+- (void)setStateDelegate:(nullable id<DIMSessionStateDelegate>)delegate;
+
 - (void)pause;
 - (void)resume;
 
@@ -64,6 +107,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface DIMClientSession (Pack)
 
+// packages after the 'SN' head, as slices of the payload (not copied)
 + (NSArray<NSData *> *)fetchDataPackages:(id<STArrival>)arrival;
 
 @end
@@ -73,6 +117,11 @@ NS_ASSUME_NONNULL_BEGIN
 - (NSArray<NSData *> *)processData:(NSData *)pack
                         fromRemote:(id<NIOSocketAddress>)source;
 
+// process package with the envelope scanned already, nil when not found
+- (NSArray<NSData *> *)processData:(NSData *)pack
+                          envelope:(nullable DIMLazyEnvelope *)env
+                        fromRemote:(id<NIOSocketAddress>)source;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -38,80 +38,134 @@
 #import <DIMSDK/DIMSDK.h>
 
 #import "STStreamArrival.h"
+#import "DIMLazyEnvelope.h"
 #import "DIMClientSession+State.h"
 
 #import "DIMClientSession.h"
 
-static NSData *sn_start = nil;
-static NSData *sn_end = nil;
+static const unsigned char sn_start[] = "Mars SN:";
+static const NSUInteger sn_start_len = sizeof(sn_start) - 1;
 
-static inline NSData *fetch_sn(NSData *data) {
-    OKSingletonDispatchOnce(^{
-        sn_start = MKUTF8Encode(@"Mars SN:");
-        sn_end = MKUTF8Encode(@"\n");
+static dispatch_data_t separator = nil;
+
+// length of the head "Mars SN:...\n", 0 if not found
+static inline NSUInteger fetch_sn(const unsigned char *buffer, NSUInteger length) {
+    if (length <= sn_start_len || memcmp(buffer, sn_start, sn_start_len) != 0) {
+        return 0;
+    }
+    const unsigned char *pos = buffer + sn_start_len;
+    const unsigned char *end = memchr(pos, '\n', length - sn_start_len);
+    if (!end || end == pos) {
+        // SN empty
+        return 0;
+    }
+    return end - buffer + 1;
+}
+
+// wrap data buffer without copying, the data will be retained until
+// all the slices are released
+static inline dispatch_data_t wrap_data(NSData *data) {
+    return dispatch_data_create([data bytes], [data length], NULL, ^{
+        [data length];
     });
+}
 
-    NSData *sn = nil;
-    NSRange range = NSMakeRange(0, sn_start.length);
-    if (data.length > sn_start.length && [[data subdataWithRange:range] isEqualToData:sn_start]) {
-        range = NSMakeRange(0, data.length);
-        range = [data rangeOfData:sn_end options:0 range:range];
-        if (range.location > sn_start.length) {
-            range = NSMakeRange(0, range.location + range.length);
-            sn = [data subdataWithRange:range];
+static inline NSData *slice_data(dispatch_data_t whole, NSUInteger offset, NSUInteger length) {
+    return (NSData *)dispatch_data_create_subrange(whole, offset, length);
+}
+
+static inline NSArray<NSData *> *split_lines(dispatch_data_t whole, const unsigned char *buffer,
+                                             NSUInteger offset, NSUInteger length) {
+    NSMutableArray *mArray = [[NSMutableArray alloc] init];
+    const unsigned char *pos;
+    NSUInteger end;
+    while (offset < length) {
+        pos = memchr(buffer + offset, '\n', length - offset);
+        end = pos ? pos - buffer : length;
+        if (end > offset) {
+            [mArray addObject:slice_data(whole, offset, end - offset)];
         }
+        offset = end + 1;  // skip '\n'
+    }
+    return mArray;
+}
+
+// split packages after the head, as slices of the whole data
+static inline NSArray<NSData *> *split_packages(NSData *data, dispatch_data_t whole,
+                                                NSUInteger offset) {
+    const unsigned char *buffer = [data bytes];
+    NSUInteger length = [data length];
+    if (offset == length) {
+        return @[];
+    } else if (buffer[offset] == '{') {
+        // JSON format
+        //     the data buffer may contain multi messages (separated by '\n'),
+        //     so we should split them here.
+        return split_lines(whole, buffer, offset, length);
+    } else if (offset == 0) {
+        // FIXME: other format?
+        return @[data];
+    } else {
+        return @[slice_data(whole, offset, length - offset)];
     }
-    return sn;
 }
 
-static inline NSData *merge_data(NSData *data1, NSData *data2) {
-    NSUInteger len1 = data1.length;
-    NSUInteger len2 = data2.length;
-    if (len1 == 0) {
-        return data2;
-    } else if (len2 == 0) {
-        return data1;
+// gather data chunks without copying
+static inline dispatch_data_t append_data(dispatch_data_t chunks, NSData *data) {
+    if (!chunks) {
+        return wrap_data(data);
     }
-    NSMutableData *mData = [[NSMutableData alloc] initWithCapacity:(len1 + len2)];
-    [mData appendData:data1];
-    [mData appendData:data2];
-    return mData;
+    OKSingletonDispatchOnce(^{
+        separator = dispatch_data_create("\n", 1, NULL, DISPATCH_DATA_DESTRUCTOR_DEFAULT);
+    });
+    chunks = dispatch_data_create_concat(chunks, separator);
+    return dispatch_data_create_concat(chunks, wrap_data(data));
 }
 
-static inline bool starts_with(NSData *data, unsigned char b) {
-    if ([data length] == 0) {
-        return false;
+static inline NSArray<dispatch_queue_t> *create_lanes(NSUInteger count) {
+    dispatch_queue_attr_t attr;
+    attr = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL,
+                                                   QOS_CLASS_USER_INITIATED, 0);
+    NSMutableArray *lanes = [[NSMutableArray alloc] initWithCapacity:count];
+    for (NSUInteger index = 0; index < count; ++index) {
+        [lanes addObject:dispatch_queue_create("chat.dim.session.inbound", attr)];
     }
-    unsigned char *buffer = (unsigned char *)[data bytes];
-    return buffer[0] == b;
+    return lanes;
 }
 
-static inline NSArray<NSData *> *split_lines(NSData *data) {
-    NSMutableArray *mArray = [[NSMutableArray alloc] init];
-    [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
-        unsigned char *buffer = (unsigned char *)bytes;
-        NSUInteger pos1 = byteRange.location, pos2;
-        while (pos1 < byteRange.length) {
-            pos2 = pos1;
-            while (pos2 < byteRange.length) {
-                if (buffer[pos2] == '\n') {
-                    break;
-                } else {
-                    ++pos2;
-                }
-            }
-            if (pos2 > pos1) {
-                [mArray addObject:[data subdataWithRange:NSMakeRange(pos1, pos2 - pos1)]];
-            }
-            pos1 = pos2 + 1;  // skip '\n'
-        }
-    }];
-    return mArray;
+// the same conversation (sender, group) always goes to the same lane,
+// so its messages will be processed in order
+static inline NSUInteger lane_for_envelope(NSUInteger count, DIMLazyEnvelope *env) {
+    NSUInteger hash = 0;
+    if (env) {
+        // personal message goes with the sender only
+        NSString *group = env.group ? env.group : env.receiver;
+        hash = [env.sender hash] ^ ([group hash] * 31);
+    }
+    return hash % count;
 }
 
+// packer & processor of a lane, created in the lane when the first package comes
+@interface __InboundWorker : NSObject {
+    
+    @public
+    dispatch_queue_t _lane;
+    id<DIMPacker> _packer;
+    id<DIMProcessor> _processor;
+}
+
+@end
+
+@implementation __InboundWorker
+
+@end
+
 @interface DIMClientSession () {
     
     NSString *_key;
+    NSString *_resumableKey;
+    
+    NSArray<__InboundWorker *> *_workers;  // for inbound lanes
 }
 
 @property(nonatomic, strong) __kindof id<MKMStation> station;
@@ -122,10 +176,30 @@ static inline NSArray<NSData *> *split_lines(NSData *data) {
 
 @property(nonatomic, strong) SMThread *thread;
 
+@property(nonatomic, strong) DIMReconnectScheduler *reconnector;
+
+// private
+- (BOOL)isDuplicatedPackage:(NSData *)pack
+                   envelope:(nullable DIMLazyEnvelope *)env
+                  signature:(NSString * _Nullable * _Nonnull)signature;
+
+// private
+- (NSArray<NSData *> *)processPackage:(NSData *)pack
+                             envelope:(nullable DIMLazyEnvelope *)env
+                            signature:(nullable NSString *)signature;
+
+// private
+- (NSArray<NSData *> *)processData:(NSData *)pack
+                          envelope:(nullable DIMLazyEnvelope *)env
+                        fromRemote:(id<NIOSocketAddress>)source
+                            worker:(__InboundWorker *)worker;
+
 @end
 
 @implementation DIMClientSession
 
+@synthesize inboundLanes = _inboundLanes;
+
 - (instancetype)initWithDatabase:(id<DIMSessionDBI>)db
                          station:(id<MKMStation>)server {
     id<NIOSocketAddress> remote;
@@ -138,11 +212,42 @@ static inline NSArray<NSData *> *split_lines(NSData *data) {
         _fsm = [[DIMSessionStateMachine alloc] initWithSession:self];
         _thread = nil;
         _key = nil;
+        _resumableKey = nil;
         _thread = nil;
+        _reconnector = [[DIMReconnectScheduler alloc] init];
+        _duplicateFilter = nil;
+        // process received packages on the gate thread by default
+        _inboundLanes = @[];
+        _workers = @[];
     }
     return self;
 }
 
+- (void)setInboundLanes:(NSArray<dispatch_queue_t> *)lanes {
+    NSMutableArray<__InboundWorker *> *workers;
+    workers = [[NSMutableArray alloc] initWithCapacity:[lanes count]];
+    __InboundWorker *worker;
+    for (dispatch_queue_t lane in lanes) {
+        worker = [[__InboundWorker alloc] init];
+        worker->_lane = lane;
+        [workers addObject:worker];
+    }
+    @synchronized (self) {
+        _inboundLanes = lanes;
+        _workers = workers;
+    }
+}
+
+- (NSArray<dispatch_queue_t> *)inboundLanes {
+    @synchronized (self) {
+        return _inboundLanes;
+    }
+}
+
++ (NSArray<dispatch_queue_t> *)createInboundLanes:(NSUInteger)count {
+    return create_lanes(count);
+}
+
 - (id<MKMStation>)station {
     return _station;
 }
@@ -157,6 +262,27 @@ static inline NSArray<NSData *> *split_lines(NSData *data) {
 
 - (void)setSessionKey:(nullable NSString *)key {
     _key = key;
+    if (key) {
+        // handshake success
+        _resumableKey = nil;
+        [_reconnector reset];
+    }
+}
+
+- (NSString *)fetchResumableKey {
+    NSString *key = _resumableKey;
+    _resumableKey = nil;
+    return key;
+}
+
+// Override
+- (BOOL)setIdentifier:(id<MKMID>)user {
+    BOOL changed = [super setIdentifier:user];
+    if (changed) {
+        // the session key belongs to the old user
+        _resumableKey = nil;
+    }
+    return changed;
 }
 
 - (BOOL)isReady {
@@ -189,6 +315,10 @@ static inline NSArray<NSData *> *split_lines(NSData *data) {
     [_fsm start];
 }
 
+- (void)setStateDelegate:(id<DIMSessionStateDelegate>)delegate {
+    _fsm.delegate = delegate;
+}
+
 - (void)pause {
     [_fsm pause];
 }
@@ -210,6 +340,45 @@ static inline NSArray<NSData *> *split_lines(NSData *data) {
     _thread = nil;
 }
 
+// Override
+- (BOOL)process {
+    if (![self isActive]) {
+        NSTimeInterval now = OKGetCurrentTimeInterval();
+        if ([_reconnector fireWithTime:now]) {
+            [self reconnect];
+        }
+    }
+    return [super process];
+}
+
+// Override
+- (BOOL)shouldJournalMessage:(id<DKDReliableMessage>)rMsg {
+    // before handshake accepted, only the handshake command can go out,
+    // it will be created again after restarted
+    return [self isReady];
+}
+
+// protected
+- (void)reconnect {
+    STCommonGate *gate = [self gate];
+    id<NIOSocketAddress> remote = [self remoteAddress];
+    id<STDocker> docker = [gate dockerForAdvanceParty:nil
+                                        remoteAddress:remote
+                                         localAddress:nil];
+    if (docker && [docker status] == STDockerStatusError) {
+        // the dead docker will be returned again until removed,
+        // close it with the channel to create a new connection
+        [gate closeDockerForRemoteAddress:remote localAddress:nil];
+        docker = [gate dockerForAdvanceParty:nil
+                               remoteAddress:remote
+                                localAddress:nil];
+    }
+    if ([docker status] != STDockerStatusReady) {
+        // not connected yet, check again later
+        [_reconnector scheduleWithTime:OKGetCurrentTimeInterval()];
+    }
+}
+
 // Override
 - (void)setup {
     [self setActive:YES time:0];
@@ -232,9 +401,15 @@ static inline NSArray<NSData *> *split_lines(NSData *data) {
     //[super docker:worker changedStatus:previous toStatus:current];
     if (current == STDockerStatusError) {
         // connection error or session finished
-        // TODO: reconnect?
         [self setActive:NO time:0];
-        // TODO: clear session ID and handshake again
+        // keep the session key for resuming after reconnected,
+        // and clear it to handshake again
+        if (_key) {
+            _resumableKey = _key;
+            _key = nil;
+        }
+        // reconnect later with backoff
+        [_reconnector scheduleWithTime:OKGetCurrentTimeInterval()];
     } else if (current == STDockerStatusReady) {
         // connected/ reconnected
         [self setActive:YES time:0];
@@ -246,60 +421,154 @@ static inline NSArray<NSData *> *split_lines(NSData *data) {
     //[super docker:worker receivedShip:arrival];
     STStreamArrival *ship = (STStreamArrival *)arrival;
     NSData *data = [ship payload];
+    const unsigned char *buffer = [data bytes];
+    NSUInteger length = [data length];
+    dispatch_data_t whole = wrap_data(data);
     
     // 0. fetch SN from data head
-    NSData *head = fetch_sn(data);
-    if (head.length > 0) {
-        NSRange range = NSMakeRange(head.length, data.length - head.length);
-        data = [data subdataWithRange:range];
-        NSLog(@"got data with head [%@] body: %lu byte(s)", MKUTF8Decode(head), [data length]);
+    NSUInteger offset = fetch_sn(buffer, length);
+    dispatch_data_t head = nil;
+    if (offset > 0) {
+        head = dispatch_data_create_subrange(whole, 0, offset);
+        NSLog(@"got data with head [%@] body: %lu byte(s)",
+              MKUTF8Decode((NSData *)head), length - offset);
     }
     
     // 1. split data when multi packages received one time
-    NSArray<NSData *> *packages;
-    if ([data length] == 0) {
-        packages = @[];
-    } else if (starts_with(data, '{')) {
-        // JSON format
-        //     the data buffer may contain multi messages (separated by '\n'),
-        //     so we should split them here.
-        packages = split_lines(data);
-    } else {
-        // FIXME: other format?
-        packages = @[data];
-    }
+    NSArray<NSData *> *packages = split_packages(data, whole, offset);
     id<NIOSocketAddress> source = [worker remoteAddress];
-
-    // 2. process package data one by one
-    NSData *SEPARATOR = MKUTF8Encode(@"\n");
-    NSMutableData *mData = [[NSMutableData alloc] init];
-    NSArray<NSData *> *responses;
-    for (NSData *pack in packages) {
-        responses = [self processData:pack fromRemote:source];
-        // combine responses
-        for (NSData *res in responses) {
-            [mData appendData:res];
-            [mData appendData:SEPARATOR];
+    id<NIOSocketAddress> destination = [worker localAddress];
+    
+    NSArray<__InboundWorker *> *workers;
+    @synchronized (self) {
+        workers = _workers;
+    }
+    if ([workers count] < 2) {
+        // 2. process package data one by one
+        dispatch_data_t body = nil;
+        NSArray<NSData *> *responses;
+        for (NSData *pack in packages) {
+            responses = [self processData:pack fromRemote:source];
+            // combine responses (separated by '\n')
+            for (NSData *res in responses) {
+                body = append_data(body, res);
+            }
         }
+        [self respondWithHead:head body:body forArrival:arrival
+                remoteAddress:source localAddress:destination];
+        return;
     }
-    if ([mData length] > 0) {
-        // drop last '\n'
-        data = [mData subdataWithRange:NSMakeRange(0, [mData length] - 1)];
-    } else {
-        data = nil;
+    
+    // 2. scan envelopes here, verify & decrypt in lanes with their own
+    //    packers & processors, different conversations will be processed
+    //    in parallel
+    NSUInteger count = [packages count];
+    NSMutableArray<NSArray<NSData *> *> *results;
+    results = [[NSMutableArray alloc] initWithCapacity:count];
+    dispatch_group_t tasks = dispatch_group_create();
+    for (NSUInteger index = 0; index < count; ++index) {
+        [results addObject:@[]];
+        NSData *pack = [packages objectAtIndex:index];
+        DIMLazyEnvelope *env = [DIMLazyEnvelope envelopeWithData:pack];
+        __InboundWorker *lane = [workers objectAtIndex:lane_for_envelope([workers count], env)];
+        dispatch_group_async(tasks, lane->_lane, ^{
+            NSArray<NSData *> *responses = [self processData:pack envelope:env
+                                                  fromRemote:source worker:lane];
+            @synchronized (results) {
+                [results replaceObjectAtIndex:index withObject:responses];
+            }
+        });
+    }
+    
+    // 3. combine responses in the original order, and send them with the 'SN'
+    //    in one time, after all packages in this ship processed
+    dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+    dispatch_group_notify(tasks, queue, ^{
+        dispatch_data_t body = nil;
+        for (NSArray<NSData *> *responses in results) {
+            for (NSData *res in responses) {
+                body = append_data(body, res);
+            }
+        }
+        [self respondWithHead:head body:body forArrival:arrival
+                remoteAddress:source localAddress:destination];
+    });
+}
+
+// private
+- (void)respondWithHead:(nullable dispatch_data_t)head
+                   body:(nullable dispatch_data_t)body
+             forArrival:(id<STArrival>)arrival
+          remoteAddress:(id<NIOSocketAddress>)source
+           localAddress:(id<NIOSocketAddress>)destination {
+    if (head && body) {
+        // head ends with '\n' already
+        body = dispatch_data_create_concat(head, body);
+    } else if (head) {
+        body = head;
     }
-    if (head.length > 0 || [data length] > 0) {
+    if (body) {
         // NOTICE: sending 'SN' back to the server for confirming
         //         that the client have received the pushing message
         STCommonGate *gate = [self gate];
-        id<NIOSocketAddress> destination = [worker localAddress];
-        [gate sendResponse:merge_data(head, data)
+        [gate sendResponse:(NSData *)body
             forArrivalShip:arrival
              remoteAddress:source
               localAddress:destination];
     }
 }
 
+// private
+- (BOOL)isDuplicatedPackage:(NSData *)pack
+                   envelope:(nullable DIMLazyEnvelope *)env
+                  signature:(NSString * _Nullable * _Nonnull)signature {
+    DIMDuplicateFilter *filter = [self duplicateFilter];
+    if (!filter || !env) {
+        return NO;
+    }
+    *signature = [env signature];
+    if (*signature && [filter checkSignature:*signature length:[pack length]]) {
+        // received before, the 'SN' will still be responded
+        // to stop the station pushing it again
+        return YES;
+    }
+    return NO;
+}
+
+// private, running in the lane of the worker
+- (NSArray<NSData *> *)processData:(NSData *)pack
+                          envelope:(nullable DIMLazyEnvelope *)env
+                        fromRemote:(id<NIOSocketAddress>)source
+                            worker:(__InboundWorker *)worker {
+    DIMCommonMessenger *messenger = [self messenger];
+    if (!messenger) {
+        return @[];
+    } else if (!worker->_packer) {
+        worker->_packer = [messenger createWorkerPacker];
+        worker->_processor = [messenger createWorkerProcessor];
+    }
+    __block NSArray<NSData *> *responses;
+    [messenger performWithPacker:worker->_packer processor:worker->_processor block:^{
+        responses = [self processData:pack envelope:env fromRemote:source];
+    }];
+    return responses;
+}
+
+// private
+- (NSArray<NSData *> *)processPackage:(NSData *)pack
+                             envelope:(nullable DIMLazyEnvelope *)env
+                            signature:(nullable NSString *)signature {
+    DIMCommonMessenger *messenger = [self messenger];
+    BOOL accepted = NO;
+    NSArray<NSData *> *responses = [messenger processPackage:pack envelope:env accepted:&accepted];
+    if (signature && accepted) {
+        // remember the processed ones only, the failed or dropped ones
+        // can be processed again when pushed next time
+        [[self duplicateFilter] addSignature:signature];
+    }
+    return responses;
+}
+
 @end
 
 @implementation DIMClientSession (Pack)
@@ -310,10 +579,10 @@ static inline NSArray<NSData *> *split_lines(NSData *data) {
     // check payload
     if (payload.length == 0) {
         return @[];
-    } else {
-        // TODO: split JsON in lines
-        return @[payload];
     }
+    // skip the 'SN' head, and split JsON in lines without copying
+    NSUInteger offset = fetch_sn([payload bytes], [payload length]);
+    return split_packages(payload, wrap_data(payload), offset);
 }
 
 @end
@@ -322,8 +591,18 @@ static inline NSArray<NSData *> *split_lines(NSData *data) {
 
 - (NSArray<NSData *> *)processData:(NSData *)pack
                         fromRemote:(id<NIOSocketAddress>)source {
-    DIMMessenger *messenger = [self messenger];
-    return [messenger processPackage:pack];
+    DIMLazyEnvelope *env = [DIMLazyEnvelope envelopeWithData:pack];
+    return [self processData:pack envelope:env fromRemote:source];
+}
+
+- (NSArray<NSData *> *)processData:(NSData *)pack
+                          envelope:(nullable DIMLazyEnvelope *)env
+                        fromRemote:(id<NIOSocketAddress>)source {
+    NSString *signature = nil;
+    if ([self isDuplicatedPackage:pack envelope:env signature:&signature]) {
+        return @[];
+    }
+    return [self processPackage:pack envelope:env signature:signature];
 }
 
 @end
@@ -0,0 +1,97 @@
+// license: https://mit-license.org
+//
+//  DIM-SDK : Decentralized Instant Messaging Software Development Kit
+//
+//                               Written in 2026 by agent <agent@local>
+//
+// =============================================================================
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// =============================================================================
+//
+//  DIMOutbox.h
+//  DIMClient
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import <DIMSDK/DIMSDK.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface DIMOutboxItem : NSObject
+
+@property(nonatomic, readonly) id<DKDReliableMessage> message;
+@property(nonatomic, readonly) NSData *package;
+@property(nonatomic, readonly) NSInteger priority;
+@property(nonatomic, readonly) NSTimeInterval time;
+
+@end
+
+/**
+ *  Outbox
+ *  ~~~~~~
+ *
+ *  Keep the packed messages (signed & serialized) before handshake
+ *  accepted, so they can be sent out in one burst after that,
+ *  without encrypting again.
+ *
+ *  When the box is full, the oldest one with the slowest priority
+ *  will be dropped; and the expired ones will not be sent.
+ */
+@interface DIMOutbox : NSObject
+
+// max lifetime of a held message (default 10 minutes)
+@property(nonatomic, assign) NSTimeInterval timeToLive;
+
+// caps (default 1024 messages, 4 MB)
+@property(nonatomic, assign) NSUInteger maxCount;
+@property(nonatomic, assign) NSUInteger maxLength;
+
+@property(nonatomic, readonly) NSUInteger count;
+@property(nonatomic, readonly) NSUInteger length;
+
+// count of messages dropped for expired or box full
+@property(nonatomic, readonly) NSUInteger droppedCount;
+
+/**
+ *  Hold a packed message
+ *
+ * @param rMsg  - signed message
+ * @param data  - serialized message
+ * @param prior - smaller is faster
+ */
+- (void)holdMessage:(id<DKDReliableMessage>)rMsg
+            package:(NSData *)data
+           priority:(NSInteger)prior;
+
+/**
+ *  Take out all living messages
+ *
+ * @param now - current time
+ * @return items sorted by priority, then by time
+ */
+- (NSArray<DIMOutboxItem *> *)removeAllItems:(NSTimeInterval)now;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,157 @@
+// license: https://mit-license.org
+//
+//  DIM-SDK : Decentralized Instant Messaging Software Development Kit
+//
+//                               Written in 2026 by agent <agent@local>
+//
+// =============================================================================
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// =============================================================================
+//
+//  DIMOutbox.m
+//  DIMClient
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import "DIMOutbox.h"
+
+@interface DIMOutboxItem ()
+
+@property(nonatomic, strong) id<DKDReliableMessage> message;
+@property(nonatomic, strong) NSData *package;
+@property(nonatomic, assign) NSInteger priority;
+@property(nonatomic, assign) NSTimeInterval time;
+
+@end
+
+@implementation DIMOutboxItem
+
+@end
+
+@interface DIMOutbox () {
+    
+    NSMutableArray<DIMOutboxItem *> *_items;  // in holding order
+    NSUInteger _length;
+    NSUInteger _droppedCount;
+}
+
+@end
+
+@implementation DIMOutbox
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _items = [[NSMutableArray alloc] init];
+        _length = 0;
+        _droppedCount = 0;
+        _timeToLive = 600;
+        _maxCount = 1024;
+        _maxLength = 1 << 22;  // 4 MB
+    }
+    return self;
+}
+
+- (NSUInteger)count {
+    @synchronized (self) {
+        return [_items count];
+    }
+}
+
+- (NSUInteger)length {
+    @synchronized (self) {
+        return _length;
+    }
+}
+
+- (NSUInteger)droppedCount {
+    @synchronized (self) {
+        return _droppedCount;
+    }
+}
+
+- (void)holdMessage:(id<DKDReliableMessage>)rMsg
+            package:(NSData *)data
+           priority:(NSInteger)prior {
+    DIMOutboxItem *item = [[DIMOutboxItem alloc] init];
+    item.message = rMsg;
+    item.package = data;
+    item.priority = prior;
+    item.time = OKGetCurrentTimeInterval();
+    @synchronized (self) {
+        [_items addObject:item];
+        _length += [data length];
+        while ([_items count] > _maxCount || (_length > _maxLength && [_items count] > 1)) {
+            [self dropOne];
+        }
+    }
+}
+
+// private
+- (void)dropOne {
+    // the oldest one with the slowest priority
+    NSUInteger pos = 0;
+    NSInteger slowest = [[_items firstObject] priority];
+    NSUInteger count = [_items count];
+    DIMOutboxItem *item;
+    for (NSUInteger index = 1; index < count; ++index) {
+        item = [_items objectAtIndex:index];
+        if (item.priority > slowest) {
+            slowest = item.priority;
+            pos = index;
+        }
+    }
+    item = [_items objectAtIndex:pos];
+    NSLog(@"[OUTBOX] box full, drop message: %@ => %@", item.message.sender, item.message.receiver);
+    _length -= [item.package length];
+    ++_droppedCount;
+    [_items removeObjectAtIndex:pos];
+}
+
+- (NSArray<DIMOutboxItem *> *)removeAllItems:(NSTimeInterval)now {
+    NSMutableArray<DIMOutboxItem *> *living;
+    @synchronized (self) {
+        living = [[NSMutableArray alloc] initWithCapacity:[_items count]];
+        for (DIMOutboxItem *item in _items) {
+            if (item.time + _timeToLive < now) {
+                NSLog(@"[OUTBOX] message expired: %@ => %@", item.message.sender, item.message.receiver);
+                ++_droppedCount;
+                continue;
+            }
+            [living addObject:item];
+        }
+        [_items removeAllObjects];
+        _length = 0;
+    }
+    // stable sort, keep holding order for the same priority
+    [living sortWithOptions:NSSortStable usingComparator:^NSComparisonResult(DIMOutboxItem *a,
+                                                                           DIMOutboxItem *b) {
+        if (a.priority == b.priority) {
+            return NSOrderedSame;
+        }
+        return a.priority < b.priority ? NSOrderedAscending : NSOrderedDescending;
+    }];
+    return living;
+}
+
+@end
@@ -0,0 +1,92 @@
+// license: https://mit-license.org
+//
+//  DIM-SDK : Decentralized Instant Messaging Software Development Kit
+//
+//                               Written in 2026 by agent <agent@local>
+//
+// =============================================================================
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// =============================================================================
+//
+//  DIMStationRacer.h
+//  DIMClient
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import <DIMClient/DIMClientSession+State.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class DIMTerminal;
+
+typedef void (^DIMStationRacerCompletionHandler)(DIMClientSession * _Nullable session);
+
+/**
+ *  Station Racer
+ *  ~~~~~~~~~~~~~
+ *
+ *  Connect to several stations with staggered starts,
+ *  keep the first session connected, and stop all the others.
+ *
+ *  The connecting time (milliseconds) will be saved in 'chosen' of the
+ *  station info, so the faster stations will be tried first next time;
+ *  stations never measured (chosen = 0) will be tried after them.
+ */
+@interface DIMStationRacer : NSObject <DIMSessionStateDelegate>
+
+// max stations to connect in one race (default 3)
+@property(nonatomic, assign) NSUInteger maxCandidates;
+
+// delay before connecting to the next station (default 0.25s)
+@property(nonatomic, assign) NSTimeInterval staggerInterval;
+
+// give up when no station connected in time (default 16s)
+@property(nonatomic, assign) NSTimeInterval timeout;
+
+- (instancetype)initWithTerminal:(DIMTerminal *)terminal
+NS_DESIGNATED_INITIALIZER;
+
+/**
+ *  Start racing
+ *
+ *  The handler will be called on the winner's state machine thread,
+ *  before it starts handshaking; or with nil when all stations failed.
+ *
+ * @param stations - station infos from database
+ * @param handler  - callback with the winner session
+ */
+- (void)raceStations:(NSArray<DIMStationInfo *> *)stations
+   completionHandler:(DIMStationRacerCompletionHandler)handler;
+
+/**
+ *  Sort stations by measured connecting time
+ *
+ * @param stations - station infos
+ * @return faster stations first
+ */
++ (NSArray<DIMStationInfo *> *)sortStations:(NSArray<DIMStationInfo *> *)stations;
+
+@end
+
+NS_ASSUME_NONNULL_END
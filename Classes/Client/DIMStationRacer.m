@@ -0,0 +1,311 @@
+// license: https://mit-license.org
+//
+//  DIM-SDK : Decentralized Instant Messaging Software Development Kit
+//
+//                               Written in 2026 by agent <agent@local>
+//
+// =============================================================================
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// =============================================================================
+//
+//  DIMStationRacer.m
+//  DIMClient
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import "DIMTerminal.h"
+
+#import "DIMStationRacer.h"
+
+@interface __RaceCandidate : NSObject {
+    
+    @public
+    DIMStationInfo *_info;
+    DIMClientSession *_session;
+    NSTimeInterval _startTime;
+    BOOL _failed;
+}
+
+@end
+
+@implementation __RaceCandidate
+
+@end
+
+@interface DIMStationRacer () {
+    
+    NSMutableArray<__RaceCandidate *> *_candidates;
+    NSUInteger _expected;
+    DIMStationRacerCompletionHandler _handler;
+    BOOL _finished;
+}
+
+@property(nonatomic, weak) DIMTerminal *terminal;
+
+@end
+
+@implementation DIMStationRacer
+
+- (instancetype)init {
+    NSAssert(false, @"DON'T call me!");
+    DIMTerminal *terminal = nil;
+    return [self initWithTerminal:terminal];
+}
+
+/* designated initializer */
+- (instancetype)initWithTerminal:(DIMTerminal *)terminal {
+    if (self = [super init]) {
+        self.terminal = terminal;
+        _candidates = [[NSMutableArray alloc] init];
+        _expected = 0;
+        _handler = nil;
+        _finished = NO;
+        _maxCandidates = 3;
+        _staggerInterval = 0.25;
+        _timeout = 16;
+    }
+    return self;
+}
+
++ (NSArray<DIMStationInfo *> *)sortStations:(NSArray<DIMStationInfo *> *)stations {
+    return [stations sortedArrayUsingComparator:^NSComparisonResult(DIMStationInfo *a,
+                                                                    DIMStationInfo *b) {
+        NSInteger x = a.chosen > 0 ? a.chosen : NSIntegerMax;
+        NSInteger y = b.chosen > 0 ? b.chosen : NSIntegerMax;
+        if (x == y) {
+            return NSOrderedSame;
+        }
+        return x < y ? NSOrderedAscending : NSOrderedDescending;
+    }];
+}
+
+- (void)raceStations:(NSArray<DIMStationInfo *> *)stations
+   completionHandler:(DIMStationRacerCompletionHandler)handler {
+    NSArray<DIMStationInfo *> *sorted = [DIMStationRacer sortStations:stations];
+    NSUInteger count = MIN([sorted count], _maxCandidates);
+    if (count == 0) {
+        NSLog(@"[RACER] no station to connect");
+        handler(nil);
+        return;
+    }
+    @synchronized (self) {
+        NSAssert(!_handler, @"racing already");
+        _expected = count;
+        _handler = handler;
+        _finished = NO;
+    }
+    dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_UTILITY, 0);
+    dispatch_time_t when;
+    for (NSUInteger index = 0; index < count; ++index) {
+        DIMStationInfo *info = [sorted objectAtIndex:index];
+        when = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(index * _staggerInterval * NSEC_PER_SEC));
+        dispatch_after(when, queue, ^{
+            [self startCandidate:info];
+        });
+    }
+    when = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_timeout * NSEC_PER_SEC));
+    dispatch_after(when, queue, ^{
+        [self finishWithWinner:nil];
+    });
+}
+
+// private
+- (void)startCandidate:(DIMStationInfo *)info {
+    DIMTerminal *terminal = [self terminal];
+    if (!terminal) {
+        return;
+    }
+    @synchronized (self) {
+        if (_finished) {
+            // the race is over
+            return;
+        }
+    }
+    __RaceCandidate *candidate = [[__RaceCandidate alloc] init];
+    candidate->_info = info;
+    candidate->_startTime = OKGetCurrentTimeInterval();
+    candidate->_failed = NO;
+    NSLog(@"[RACER] connecting to %@:%u", info.host, info.port);
+    // create session outside the lock, so the candidates connect in parallel;
+    // and watch its states from the start, so it won't handshake before winning
+    id<MKMStation> station = [terminal createStationWithHost:info.host port:info.port];
+    NSDictionary *dict = [info socketOptions];
+    STSocketOptions *options = dict ? [[STSocketOptions alloc] initWithDictionary:dict] : nil;
+    DIMClientSession *session = [terminal createSessionWithStation:station
+                                                     socketOptions:options
+                                                     stateDelegate:self];
+    candidate->_session = session;
+    BOOL over;
+    BOOL finish = NO;
+    @synchronized (self) {
+        over = _finished;
+        if (!over) {
+            [_candidates addObject:candidate];
+            // states changed before the candidate added were ignored, check again
+            finish = [self checkCandidate:candidate state:[session state]];
+        }
+    }
+    if (over) {
+        // the race is over while connecting
+        [session setStateDelegate:nil];
+        [session stop];
+    } else if (finish) {
+        [self finishWithWinner:(candidate->_failed ? nil : candidate)];
+    }
+}
+
+// private
+- (BOOL)checkCandidate:(__RaceCandidate *)candidate state:(nullable DIMSessionState *)current {
+    if (!current || candidate->_failed) {
+        return NO;
+    } else if (current.index == DIMSessionStateOrderConnected) {
+        // the first connected one wins
+        return YES;
+    } else if (current.index != DIMSessionStateOrderError) {
+        return NO;
+    }
+    candidate->_failed = YES;
+    NSLog(@"[RACER] failed to connect %@:%u", candidate->_info.host, candidate->_info.port);
+    if ([_candidates count] < _expected) {
+        // waiting for others
+        return NO;
+    }
+    for (__RaceCandidate *item in _candidates) {
+        if (!item->_failed) {
+            // waiting for others
+            return NO;
+        }
+    }
+    // all failed
+    return YES;
+}
+
+// private
+- (nullable __RaceCandidate *)candidateForSession:(DIMClientSession *)session {
+    for (__RaceCandidate *item in _candidates) {
+        if (item->_session == session) {
+            return item;
+        }
+    }
+    return nil;
+}
+
+// private
+- (void)finishWithWinner:(nullable __RaceCandidate *)winner {
+    DIMStationRacerCompletionHandler handler;
+    NSArray<__RaceCandidate *> *losers;
+    @synchronized (self) {
+        if (_finished) {
+            return;
+        }
+        _finished = YES;
+        handler = _handler;
+        _handler = nil;
+        losers = [_candidates copy];
+        [_candidates removeAllObjects];
+    }
+    DIMTerminal *terminal = [self terminal];
+    id<DIMStationDBI> db = [terminal database];
+    NSInteger chosen;
+    for (__RaceCandidate *item in losers) {
+        if (item == winner) {
+            continue;
+        }
+        [item->_session setStateDelegate:nil];
+        [item->_session stop];
+        if (item->_failed) {
+            // push the failed station back
+            chosen = (NSInteger)(_timeout * 1000);
+            [self updateStation:item->_info chosen:chosen database:db];
+        }
+    }
+    DIMClientSession *session = nil;
+    if (winner) {
+        session = winner->_session;
+        chosen = (NSInteger)((OKGetCurrentTimeInterval() - winner->_startTime) * 1000);
+        chosen = MAX(chosen, 1);
+        [self updateStation:winner->_info chosen:chosen database:db];
+        NSLog(@"[RACER] connected to %@:%u in %ld ms", winner->_info.host, winner->_info.port, chosen);
+        // hand over the session to the terminal before handshaking
+        [session setStateDelegate:terminal];
+    } else {
+        NSLog(@"[RACER] failed to connect any station");
+    }
+    if (handler) {
+        handler(session);
+    }
+}
+
+// private
+- (void)updateStation:(DIMStationInfo *)info chosen:(NSInteger)order database:(id<DIMStationDBI>)db {
+    info.chosen = order;
+    [db updateStation:info.identifier
+               chosen:order
+                 host:info.host
+                 port:info.port
+             provider:info.provider];
+}
+
+#pragma mark DIMSessionStateDelegate
+
+// Override
+- (void)machine:(id<SMContext>)ctx enterState:(id<SMState>)next
+           time:(NSTimeInterval)now {
+    // called before state changed
+}
+
+// Override
+- (void)machine:(DIMSessionStateMachine *)ctx exitState:(id<SMState>)previous
+           time:(NSTimeInterval)now {
+    DIMSessionState *current = [ctx currentState];
+    if (!current) {
+        return;
+    }
+    __RaceCandidate *candidate;
+    @synchronized (self) {
+        candidate = [self candidateForSession:ctx.session];
+        if (!candidate || _finished) {
+            return;
+        }
+        if (![self checkCandidate:candidate state:current]) {
+            return;
+        }
+    }
+    // the first connected one wins; or all failed
+    [self finishWithWinner:(candidate->_failed ? nil : candidate)];
+}
+
+// Override
+- (void)machine:(id<SMContext>)ctx pauseState:(id<SMState>)current
+           time:(NSTimeInterval)now {
+    
+}
+
+// Override
+- (void)machine:(id<SMContext>)ctx resumeState:(id<SMState>)current
+           time:(NSTimeInterval)now {
+    
+}
+
+@end
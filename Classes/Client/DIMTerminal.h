@@ -69,6 +69,22 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (DIMClientSession *)createSessionWithStation:(id<MKMStation>)server;
 
+// create session and start it with the state delegate
+- (DIMClientSession *)createSessionWithStation:(id<MKMStation>)server
+                                 stateDelegate:(id<DIMSessionStateDelegate>)delegate;
+
+// create session with socket tuning profile (nil for default),
+// the options will be applied before connecting
+- (DIMClientSession *)createSessionWithStation:(id<MKMStation>)server
+                                 socketOptions:(nullable STSocketOptions *)options
+                                 stateDelegate:(id<DIMSessionStateDelegate>)delegate;
+
+// outbox journal for the first session, it will be handed over to the next
+- (nullable DIMOutboxJournal *)createOutboxJournal;
+
+// duplicate filter for the first session, it will be handed over to the next
+- (nullable DIMDuplicateFilter *)createDuplicateFilter;
+
 - (id<DIMPacker>)createPackerWithFacebook:(DIMCommonFacebook *)barrack
                                 messenger:(DIMClientMessenger *)transceiver;
 
@@ -84,6 +100,24 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (DIMClientMessenger *)connectToHost:(NSString *)ip port:(UInt16)port;
 
+/**
+ *  Connect to the station with its socket tuning profile
+ *
+ * @param info - station info from database
+ * @return messenger with the new session
+ */
+- (DIMClientMessenger *)connectToStation:(DIMStationInfo *)info;
+
+/**
+ *  Race the stations of this provider, and connect to the fastest one
+ *
+ * @param pid     - service provider ID
+ * @param handler - callback on main thread with the new messenger,
+ *                  or nil when all stations failed
+ */
+- (void)connectToProvider:(id<MKMID>)pid
+        completionHandler:(nullable void (^)(DIMClientMessenger * _Nullable messenger))handler;
+
 - (BOOL)loginUser:(id<MKMID>)user;
 
 - (void)keepOnline:(id<MKMID>)user;
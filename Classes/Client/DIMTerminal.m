@@ -48,8 +48,22 @@
 #import "DIMClientMessenger.h"
 #import "DIMGroupManager.h"
 
+#import "DIMStorage.h"
+#import "DIMStationRacer.h"
+
 #import "DIMTerminal.h"
 
+// path of the file for keeping network data across restarts
+static inline NSString *storage_path(NSString *filename) {
+    NSString *dir = [DIMStorage documentDirectory];
+    dir = [dir stringByAppendingPathComponent:@".dim"];
+    if (![DIMStorage createDirectoryAtPath:dir]) {
+        NSLog(@"failed to create directory: %@", dir);
+        return nil;
+    }
+    return [dir stringByAppendingPathComponent:filename];
+}
+
 @interface DIMTerminal () {
     
     NSTimeInterval _lastOnlineTime;
@@ -60,6 +74,9 @@
 @property(nonatomic, strong) DIMCommonFacebook *facebook;
 @property(nonatomic, strong) DIMClientMessenger *messenger;
 
+// racing for the fastest station
+@property(nonatomic, strong, nullable) DIMStationRacer *racer;
+
 @end
 
 @implementation DIMTerminal
@@ -153,9 +170,14 @@
         return;
     }
     if (current.index == DIMSessionStateOrderHandshaking) {
-        // start handshake
-        [self.messenger handshake:nil];
+        // start handshake, try to resume with the session key of the
+        // lost connection first, it will fall back to a full handshake
+        // (with meta & visa) when handshaking expired
+        NSString *sessionKey = [ctx.session fetchResumableKey];
+        [self.messenger handshake:sessionKey];
     } else if (current.index == DIMSessionStateOrderRunning) {
+        // send again the packages left in the journal last time
+        [ctx.session replayJournal];
         // broadcast current meta & visa document to all stations
         [self.messenger handshakeSuccess];
         // update last online time
@@ -201,18 +223,42 @@
 }
 
 - (DIMClientSession *)createSessionWithStation:(id<MKMStation>)server {
+    return [self createSessionWithStation:server stateDelegate:self];
+}
+
+- (DIMClientSession *)createSessionWithStation:(id<MKMStation>)server
+                                 stateDelegate:(id<DIMSessionStateDelegate>)delegate {
+    return [self createSessionWithStation:server socketOptions:nil stateDelegate:delegate];
+}
+
+- (DIMClientSession *)createSessionWithStation:(id<MKMStation>)server
+                                 socketOptions:(nullable STSocketOptions *)options
+                                 stateDelegate:(id<DIMSessionStateDelegate>)delegate {
     DIMClientSession *session;
     session = [[DIMClientSession alloc] initWithDatabase:_database
                                                  station:server];
+    if (options) {
+        // before started, the socket will be connected after that
+        [session setSocketOptions:options];
+    }
     // set current user for handshaking
     id<MKMUser> user = [_facebook currentUser];
     if (user) {
         [session setIdentifier:user.identifier];
     }
-    [session startWithStateDelegate:self];
+    [session startWithStateDelegate:delegate];
     return session;
 }
 
+- (nullable DIMOutboxJournal *)createOutboxJournal {
+    NSString *path = storage_path(@"outbox.journal");
+    return path ? [[DIMOutboxJournal alloc] initWithPath:path] : nil;
+}
+
+- (nullable DIMDuplicateFilter *)createDuplicateFilter {
+    return [[DIMDuplicateFilter alloc] initWithPath:storage_path(@"received.filter")];
+}
+
 - (id<DIMPacker>)createPackerWithFacebook:(DIMCommonFacebook *)barrack
                                 messenger:(DIMClientMessenger *)transceiver {
     return [[DIMClientMessagePacker alloc] initWithFacebook:barrack
@@ -236,6 +282,12 @@
 @implementation DIMTerminal (State)
 
 - (DIMClientMessenger *)connectToHost:(NSString *)ip port:(UInt16)port {
+    return [self connectToHost:ip port:port socketOptions:nil];
+}
+
+// private
+- (DIMClientMessenger *)connectToHost:(NSString *)ip port:(UInt16)port
+                        socketOptions:(nullable STSocketOptions *)options {
     DIMClientMessenger *messenger = [self messenger];
     if (messenger) {
         DIMClientSession *session = [messenger session];
@@ -249,11 +301,36 @@
         }
         [session stop];
     }
-    DIMCommonFacebook *facebook = [self facebook];
-    
     // create new messenger with session
     id<MKMStation> station = [self createStationWithHost:ip port:port];
-    DIMClientSession *session = [self createSessionWithStation:station];
+    DIMClientSession *session = [self createSessionWithStation:station
+                                                 socketOptions:options
+                                                 stateDelegate:self];
+    return [self installMessengerWithSession:session];
+}
+
+// private
+- (DIMClientMessenger *)installMessengerWithSession:(DIMClientSession *)session {
+    DIMClientMessenger *oldMessenger = [self messenger];
+    DIMClientSession *old = [self session];
+    if (old && old != session) {
+        // hand over the waiting messages to the new session,
+        // so they need not to be packed again
+        [session setJournal:[old journal]];
+        [session setDuplicateFilter:[old duplicateFilter]];
+        // keep the order of messages still processing in the old lanes
+        [session setInboundLanes:[old inboundLanes]];
+        [session takeOverQueueFromGateKeeper:old];
+    } else {
+        if (![session journal]) {
+            [session setJournal:[self createOutboxJournal]];
+        }
+        if (![session duplicateFilter]) {
+            [session setDuplicateFilter:[self createDuplicateFilter]];
+        }
+    }
+    DIMCommonFacebook *facebook = [self facebook];
+    DIMClientMessenger *messenger;
     messenger = [self createMessengerWithFacebook:facebook session:session];
     // create packer, processor for messenger
     // they have weak references to facebook & messenger
@@ -261,12 +338,48 @@
                                               messenger:messenger]];
     [messenger setProcessor:[self createProcessorWithFacebook:facebook
                                                     messenger:messenger]];
+    if (oldMessenger && oldMessenger != messenger) {
+        // the messages held before handshake accepted
+        // will be sent out by the new messenger
+        [messenger setOutbox:[oldMessenger outbox]];
+    }
     // set weak reference to messenger
     [session setMessenger:messenger];
     self.messenger = messenger;
     return messenger;
 }
 
+- (DIMClientMessenger *)connectToStation:(DIMStationInfo *)info {
+    NSDictionary *options = [info socketOptions];
+    return [self connectToHost:info.host port:info.port
+                 socketOptions:(options ? [[STSocketOptions alloc] initWithDictionary:options] : nil)];
+}
+
+- (void)connectToProvider:(id<MKMID>)pid
+        completionHandler:(void (^)(DIMClientMessenger * _Nullable))handler {
+    NSArray<DIMStationInfo *> *stations = [_database allStations:pid];
+    DIMStationRacer *racer = [[DIMStationRacer alloc] initWithTerminal:self];
+    self.racer = racer;
+    __weak __typeof(self) weakSelf = self;
+    [racer raceStations:stations completionHandler:^(DIMClientSession *winner) {
+        __strong __typeof(weakSelf) terminal = weakSelf;
+        DIMClientMessenger *messenger = nil;
+        if (terminal && winner) {
+            // stop the old session
+            DIMClientSession *session = [terminal session];
+            [session stop];
+            // called before handshaking, so the messenger is ready for it
+            messenger = [terminal installMessengerWithSession:winner];
+        }
+        terminal.racer = nil;
+        if (handler) {
+            [NSObject performBlockOnMainThread:^{
+                handler(messenger);
+            } waitUntilDone:NO];
+        }
+    }];
+}
+
 - (BOOL)loginUser:(id<MKMID>)user {
     DIMClientSession *session = [self session];
     if (session) {
@@ -83,6 +83,10 @@
         // S -> C: handshake accepted by station
         if (!oldKey) {
             // normal handshake response,
+            // switch frame format if the station accepted binary frames
+            if ([command.framing containsObject:DKDHandshakeFraming_Binary]) {
+                [session setBinaryFraming:YES];
+            }
             // update session key to change state to 'running'
             [session setSessionKey:newKey];
         } else if ([oldKey isEqualToString:newKey]) {
@@ -60,7 +60,7 @@ NS_DESIGNATED_INITIALIZER;
 
 /**
  * Call it when received 'UIApplicationDidReceiveMemoryWarningNotification',
- * this will remove 50% of cached objects
+ * this will remove 50% of cached objects (the least recently used ones)
  *
  * @return number of survivors
  */
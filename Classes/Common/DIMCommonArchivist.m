@@ -39,6 +39,7 @@
 #import "DIMBot.h"
 #import "DIMStation.h"
 #import "DIMServiceProvider.h"
+#import "DIMCommonFacebook.h"
 
 #import "DIMCommonArchivist.h"
 
@@ -154,7 +155,11 @@
     //  3. save into database
     //
     id<DIMAccountDBI> db = [self database];
-    return [db saveMeta:meta forID:did];
+    BOOL ok = [db saveMeta:meta forID:did];
+    if (ok) {
+        [self clearFacebookCacheForID:did];
+    }
+    return ok;
 }
 
 // Override
@@ -178,7 +183,19 @@
     //  3. save into database
     //
     id<DIMAccountDBI> db = [self database];
-    return [db saveDocument:doc forID:did];
+    BOOL ok = [db saveDocument:doc forID:did];
+    if (ok) {
+        [self clearFacebookCacheForID:did];
+    }
+    return ok;
+}
+
+// private
+- (void)clearFacebookCacheForID:(id<MKMID>)did {
+    DIMFacebook *facebook = [self facebook];
+    if ([facebook isKindOfClass:[DIMCommonFacebook class]]) {
+        [(DIMCommonFacebook *)facebook clearCacheForID:did];
+    }
 }
 
 // Override
@@ -192,11 +209,11 @@
 @implementation DIMCommonArchivist (Cache)
 
 - (id<DIMMemoryCache>)createUserCache {
-    return [[DIMThanosCache alloc] init];
+    return [[DIMStripedCache alloc] initWithCapacity:8192 stripes:8];
 }
 
 - (id<DIMMemoryCache>)createGroupCache {
-    return [[DIMThanosCache alloc] init];
+    return [[DIMStripedCache alloc] initWithCapacity:2048 stripes:4];
 }
 
 - (NSUInteger)reduceMemory {
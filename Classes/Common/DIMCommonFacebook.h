@@ -80,6 +80,41 @@ NS_DESIGNATED_INITIALIZER;
 
 @end
 
+/**
+ *  Read-through cache for meta & documents
+ *  ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ *  Meta & documents loaded from database will be cached with the parsed
+ *  last visa/bulletin, the documents will be reloaded (and checked again)
+ *  after 'DIMEntityChecker_QueryExpires'.
+ */
+@interface DIMCommonFacebook (Cache)
+
+// statistics
+@property (readonly, nonatomic) NSUInteger cacheHitCount;
+@property (readonly, nonatomic) NSUInteger cacheMissCount;
+
+// protected
+- (id<DIMMemoryCache>)createMetaCache;
+// protected
+- (id<DIMMemoryCache>)createDocumentCache;
+
+/**
+ *  Remove cached meta & documents after they're updated
+ *
+ * @param did - entity ID
+ */
+- (void)clearCacheForID:(id<MKMID>)did;
+
+/**
+ *  Call it when received 'UIApplicationDidReceiveMemoryWarningNotification'
+ *
+ * @return number of survivors
+ */
+- (NSUInteger)reduceMemory;
+
+@end
+
 @interface DIMCommonFacebook (Group)
 
 - (NSArray<id<MKMID>> *)administratorsOfGroup:(id<MKMID>)group;
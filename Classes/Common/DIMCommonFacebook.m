@@ -40,13 +40,40 @@
 #import "MKMAnonymous.h"
 #import "DIMCommonArchivist.h"
 
+#import <stdatomic.h>
+
 #import "DIMCommonFacebook.h"
 
+@interface __DocumentRecord : NSObject {
+    
+    @public
+    NSArray<id<MKMDocument>> *_documents;  // nil when not found
+    id<MKMVisa> _visa;          // last visa
+    id<MKMBulletin> _bulletin;  // last bulletin
+    NSTimeInterval _expires;
+}
+
+@end
+
+@implementation __DocumentRecord
+
+@end
+
 @interface DIMCommonFacebook () {
     
     DIMCommonArchivist *_barrack;
     
     id<MKMUser> _currentUser;
+    
+    id<DIMMemoryCache> _metaCache;
+    id<DIMMemoryCache> _documentCache;
+    
+    // increased when cache cleared, so the records loaded
+    // before that will not be cached
+    _Atomic(NSUInteger) _version;
+    
+    _Atomic(NSUInteger) _hitCount;
+    _Atomic(NSUInteger) _missCount;
 }
 
 @property (strong, nonatomic) id<DIMAccountDBI> database;
@@ -65,6 +92,11 @@
 - (instancetype)initWithDatabase:(id<DIMAccountDBI>)adb {
     if (self = [super init]) {
         self.database = adb;
+        _metaCache = [self createMetaCache];
+        _documentCache = [self createDocumentCache];
+        atomic_init(&_version, 0);
+        atomic_init(&_hitCount, 0);
+        atomic_init(&_missCount, 0);
     }
     return self;
 }
@@ -87,32 +119,39 @@
 
 - (id<MKMUser>)currentUser {
     // Get current user (for signing and sending message)
-    id<MKMUser> user = _currentUser;
-    if (user) {
+    @synchronized (self) {
+        id<MKMUser> user = _currentUser;
+        if (user) {
+            return user;
+        }
+        id<DIMAccountDBI> adb = [self database];
+        NSArray<id<MKMID>> *localUsers = [adb localUsers];
+        if ([localUsers count] == 0) {
+            return nil;
+        }
+        id<MKMID> current = [localUsers firstObject];
+        NSAssert([self privateKeyForSignature:current], @"user error: %@", current);
+        user = [self userForID:current];
+        _currentUser = user;
         return user;
     }
-    id<DIMAccountDBI> adb = [self database];
-    NSArray<id<MKMID>> *localUsers = [adb localUsers];
-    if ([localUsers count] == 0) {
-        return nil;
-    }
-    id<MKMID> current = [localUsers firstObject];
-    NSAssert([self privateKeyForSignature:current], @"user error: %@", current);
-    user = [self userForID:current];
-    _currentUser = user;
-    return user;
 }
 
 - (void)setCurrentUser:(id<MKMUser>)currentUser {
     if (!currentUser.dataSource) {
         currentUser.dataSource = self;
     }
-    _currentUser = currentUser;
+    @synchronized (self) {
+        _currentUser = currentUser;
+    }
 }
 
 // Override
 - (nullable id<MKMID>)selectLocalUserForID:(id<MKMID>)receiver {
-    id<MKMUser> user = _currentUser;
+    id<MKMUser> user;
+    @synchronized (self) {
+        user = _currentUser;
+    }
     if (user) {
         id<MKMID> current = [user identifier];
         if ([receiver isBroadcast]) {
@@ -143,18 +182,59 @@
 
 // Override
 - (id<MKMMeta>)metaForID:(id<MKMID>)did {
+    // 1. check cache
+    id<MKMMeta> meta = [_metaCache objectForKey:did.string];
+    if (meta) {
+        atomic_fetch_add_explicit(&_hitCount, 1, memory_order_relaxed);
+        return meta;
+    }
+    atomic_fetch_add_explicit(&_missCount, 1, memory_order_relaxed);
+    // 2. load from database
+    NSUInteger version = atomic_load(&_version);
     id<DIMAccountDBI> adb = [self database];
-    id<MKMMeta> meta = [adb metaForID:did];
+    meta = [adb metaForID:did];
     [self.entityChecker checkMeta:meta forID:did];
+    // 3. cache it
+    //    (meta will never change, so it needs no expires)
+    if (meta && version == atomic_load(&_version)) {
+        [_metaCache setObject:meta forKey:did.string];
+    }
     return meta;
 }
 
 // Override
 - (NSArray<id<MKMDocument>> *)documentsForID:(id<MKMID>)did {
+    return [self documentRecordForID:did]->_documents;
+}
+
+// private
+- (__DocumentRecord *)documentRecordForID:(id<MKMID>)did {
+    NSTimeInterval now = OKGetCurrentTimeInterval();
+    // 1. check cache
+    __DocumentRecord *record = [_documentCache objectForKey:did.string];
+    if (record && now < record->_expires) {
+        atomic_fetch_add_explicit(&_hitCount, 1, memory_order_relaxed);
+        return record;
+    }
+    atomic_fetch_add_explicit(&_missCount, 1, memory_order_relaxed);
+    // 2. load from database
+    NSUInteger version = atomic_load(&_version);
     id<DIMAccountDBI> adb = [self database];
     NSArray<id<MKMDocument>> *docs = [adb documentsForID:did];
     [self.entityChecker checkDocuments:docs forID:did];
-    return docs;
+    // 3. cache with parsed visa/bulletin
+    record = [[__DocumentRecord alloc] init];
+    record->_documents = docs;
+    if ([did isUser]) {
+        record->_visa = [DIMDocumentUtils lastVisa:docs];
+    } else if ([did isGroup]) {
+        record->_bulletin = [DIMDocumentUtils lastBulletin:docs];
+    }
+    record->_expires = now + DIMEntityChecker_QueryExpires;
+    if (version == atomic_load(&_version)) {
+        [_documentCache setObject:record forKey:did.string];
+    }
+    return record;
 }
 
 #pragma mark User DataSource
@@ -201,13 +281,19 @@
 }
 
 - (nullable __kindof id<MKMVisa>)visaForID:(id<MKMID>)did {
-    NSArray<id<MKMDocument>> *docs = [self documentsForID:did];
-    return [DIMDocumentUtils lastVisa:docs];
+    if (![did isUser]) {
+        NSArray<id<MKMDocument>> *docs = [self documentsForID:did];
+        return [DIMDocumentUtils lastVisa:docs];
+    }
+    return [self documentRecordForID:did]->_visa;
 }
 
 - (nullable __kindof id<MKMBulletin>)bulletinForID:(id<MKMID>)did {
-    NSArray<id<MKMDocument>> *docs = [self documentsForID:did];
-    return [DIMDocumentUtils lastBulletin:docs];
+    if (![did isGroup]) {
+        NSArray<id<MKMDocument>> *docs = [self documentsForID:did];
+        return [DIMDocumentUtils lastBulletin:docs];
+    }
+    return [self documentRecordForID:did]->_bulletin;
 }
 
 - (nullable NSString *)getName:(id<MKMID>)did {
@@ -238,6 +324,43 @@
 
 @end
 
+@implementation DIMCommonFacebook (Cache)
+
+- (NSUInteger)cacheHitCount {
+    return atomic_load_explicit(&_hitCount, memory_order_relaxed);
+}
+
+- (NSUInteger)cacheMissCount {
+    return atomic_load_explicit(&_missCount, memory_order_relaxed);
+}
+
+- (id<DIMMemoryCache>)createMetaCache {
+    return [[DIMStripedCache alloc] initWithCapacity:8192 stripes:8];
+}
+
+- (id<DIMMemoryCache>)createDocumentCache {
+    return [[DIMStripedCache alloc] initWithCapacity:8192 stripes:8];
+}
+
+- (void)clearCacheForID:(id<MKMID>)did {
+    atomic_fetch_add(&_version, 1);
+    // caches without removing will be refreshed when the records expired
+    if ([_metaCache respondsToSelector:@selector(removeObjectForKey:)]) {
+        [_metaCache removeObjectForKey:did.string];
+    }
+    if ([_documentCache respondsToSelector:@selector(removeObjectForKey:)]) {
+        [_documentCache removeObjectForKey:did.string];
+    }
+}
+
+- (NSUInteger)reduceMemory {
+    NSUInteger cnt1 = [_metaCache reduceMemory];
+    NSUInteger cnt2 = [_documentCache reduceMemory];
+    return cnt1 + cnt2;
+}
+
+@end
+
 @implementation DIMCommonFacebook (Group)
 
 - (NSArray<id<MKMID>> *)administratorsOfGroup:(id<MKMID>)group {
@@ -37,6 +37,7 @@
 
 #import <DIMClient/DIMMessageDBI.h>
 #import <DIMClient/DIMSession.h>
+#import <DIMClient/DIMLazyEnvelope.h>
 #import <DIMClient/DIMCommonFacebook.h>
 
 NS_ASSUME_NONNULL_BEGIN
@@ -56,8 +57,120 @@ NS_DESIGNATED_INITIALIZER;
 
 - (void)setPacker:(id<DIMPacker>)messagePacker;
 
+/**
+ *  Encrypt & sign messages with another packer on current thread,
+ *  so the workers don't share one packer when sending in parallel
+ *
+ * @param packer - packer owned by the worker
+ * @param block  - sending messages with this messenger
+ */
+- (void)performWithPacker:(id<DIMPacker>)packer block:(NS_NOESCAPE void (^)(void))block;
+
+/**
+ *  Verify, decrypt & process messages with another packer & processor
+ *  on current thread, so the workers can receive in parallel
+ *
+ * @param packer    - packer owned by the worker
+ * @param processor - processor owned by the worker
+ * @param block     - processing packages with this messenger
+ */
+- (void)performWithPacker:(id<DIMPacker>)packer
+                processor:(id<DIMProcessor>)processor
+                    block:(NS_NOESCAPE void (^)(void))block;
+
+/**
+ *  Create packer & processor for a worker,
+ *  default are the same kinds as the messenger's ones
+ */
+// protected
+- (id<DIMPacker>)createWorkerPacker;
+// protected
+- (id<DIMProcessor>)createWorkerProcessor;
+
 - (void)setProcessor:(id<DIMProcessor>)messageProcessor;
 
+// count of incoming packages dropped by checking envelope
+@property (readonly, nonatomic) NSUInteger droppedPackageCount;
+
+/**
+ *  Check envelope of the incoming package before deserializing it
+ *
+ * @param env  - envelope scanned from the package
+ * @param data - package data
+ * @return false to drop it (duplicated, blocked, misrouted, ...)
+ */
+// protected
+- (BOOL)checkEnvelope:(DIMLazyEnvelope *)env package:(NSData *)data;
+
+/**
+ *  Process incoming package, and tell whether it was accepted
+ *
+ * @param data - package data
+ * @param ok   - NO when dropped, or failed to verify/decrypt
+ * @return responses
+ */
+- (NSArray<NSData *> *)processPackage:(NSData *)data accepted:(BOOL *)ok;
+
+/**
+ *  Process incoming package with the envelope scanned already,
+ *  so it need not to be scanned again
+ *
+ * @param data - package data
+ * @param env  - envelope scanned from the package, nil when not found
+ * @param ok   - NO when dropped, or failed to verify/decrypt
+ * @return responses
+ */
+- (NSArray<NSData *> *)processPackage:(NSData *)data
+                             envelope:(nullable DIMLazyEnvelope *)env
+                             accepted:(BOOL *)ok;
+
+/**
+ *  Called by the processor when the message verified & decrypted,
+ *  before its content processed
+ *
+ * @param rMsg - network message
+ */
+// protected
+- (void)acceptMessage:(id<DKDReliableMessage>)rMsg;
+
+/**
+ *  Send reliable messages which were serialized already
+ *
+ * @param messages - encrypted & signed messages
+ * @param packages - serialized messages
+ * @param prior    - smaller is faster
+ * @return count of messages queued
+ */
+- (NSUInteger)sendReliableMessages:(NSArray<id<DKDReliableMessage>> *)messages
+                          packages:(NSArray<NSData *> *)packages
+                          priority:(NSInteger)prior;
+
+/**
+ *  Send content without blocking
+ *
+ *  When the session queue is backpressured, the content will not be
+ *  encrypted, and nil returned means 'would block', the caller should
+ *  try again later, or send it with a completion handler instead.
+ *
+ * @return nil when would block
+ */
+- (nullable DIMTransmitterResults *)trySendContent:(id<DKDContent>)content
+                                            sender:(nullable id<MKMID>)from
+                                          receiver:(id<MKMID>)to
+                                          priority:(NSInteger)prior;
+
+/**
+ *  Send content when the session queue can take more messages
+ *
+ * @param handler - callback in background with (iMsg, rMsg);
+ *                  or with nil when the session stopped before sending
+ */
+- (void)sendContent:(id<DKDContent>)content
+             sender:(nullable id<MKMID>)from
+           receiver:(id<MKMID>)to
+           priority:(NSInteger)prior
+  completionHandler:(nullable void (^)(DIMTransmitterResults * _Nullable results))handler;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -35,19 +35,72 @@
 //  Copyright © 2023 DIM Group. All rights reserved.
 //
 
+#import <stdatomic.h>
+
 #import "DIMCompatible.h"
 #import "DIMCompressor.h"
 
 #import "DIMCommonMessenger.h"
 
+// set when the package processing on current thread reached its content
+static _Thread_local BOOL s_packageAccepted = NO;
+
+// packer & processor of the worker running on current thread
+static _Thread_local __unsafe_unretained id<DIMPacker> s_workerPacker = nil;
+static _Thread_local __unsafe_unretained id<DIMProcessor> s_workerProcessor = nil;
+
+/**
+ *  Serialize the calls to the cipher key cache,
+ *  so the workers can get & cache symmetric keys at the same time
+ */
+@interface __LockedKeyCache : NSProxy {
+    
+    id<DIMCipherKeyDelegate> _target;
+}
+
+- (instancetype)initWithTarget:(id<DIMCipherKeyDelegate>)target;
+
+@end
+
+@implementation __LockedKeyCache
+
+- (instancetype)initWithTarget:(id<DIMCipherKeyDelegate>)target {
+    _target = target;
+    return self;
+}
+
+- (NSMethodSignature *)methodSignatureForSelector:(SEL)sel {
+    return [(NSObject *)_target methodSignatureForSelector:sel];
+}
+
+- (void)forwardInvocation:(NSInvocation *)invocation {
+    @synchronized (_target) {
+        [invocation invokeWithTarget:_target];
+    }
+}
+
+- (BOOL)respondsToSelector:(SEL)aSelector {
+    return [_target respondsToSelector:aSelector];
+}
+
+- (BOOL)conformsToProtocol:(Protocol *)aProtocol {
+    return [_target conformsToProtocol:aProtocol];
+}
+
+@end
+
 @interface DIMCommonMessenger () {
     
     DIMCommonFacebook *_facebook;
     
+    id<DIMCipherKeyDelegate> _keyCache;
+    
     id<DIMPacker> _packer;
     id<DIMProcessor> _processor;
     
     id<DIMCompressor> _compressor;
+    
+    _Atomic(NSUInteger) _droppedPackageCount;  // counted in lanes
 }
 
 @property (strong, nonatomic) id<DIMSession> session;
@@ -73,10 +126,12 @@
         _facebook = barrack;
         _session = session;
         _database = db;
+        _keyCache = db ? (id<DIMCipherKeyDelegate>)[[__LockedKeyCache alloc] initWithTarget:db] : nil;
         
         _packer = nil;
         _processor = nil;
         _compressor = [self createMessageCompressor];
+        atomic_init(&_droppedPackageCount, 0);
     }
     return self;
 }
@@ -98,27 +153,108 @@
 
 // Override
 - (__kindof id<DIMCipherKeyDelegate>)keyCache {
-    return _database;
+    return _keyCache;
 }
 
 // Override
 - (__kindof id<DIMPacker>)packer {
-    return _packer;
+    id<DIMPacker> worker = s_workerPacker;
+    return worker ? worker : _packer;
 }
 
 - (void)setPacker:(id<DIMPacker>)messagePacker {
     _packer = messagePacker;
 }
 
+- (void)performWithPacker:(id<DIMPacker>)packer block:(NS_NOESCAPE void (^)(void))block {
+    id<DIMPacker> previous = s_workerPacker;
+    s_workerPacker = packer;
+    @try {
+        block();
+    } @finally {
+        s_workerPacker = previous;
+    }
+}
+
+- (void)performWithPacker:(id<DIMPacker>)packer
+                processor:(id<DIMProcessor>)processor
+                    block:(NS_NOESCAPE void (^)(void))block {
+    id<DIMProcessor> previous = s_workerProcessor;
+    s_workerProcessor = processor;
+    @try {
+        [self performWithPacker:packer block:block];
+    } @finally {
+        s_workerProcessor = previous;
+    }
+}
+
+- (id<DIMPacker>)createWorkerPacker {
+    Class clazz = [_packer class];
+    NSAssert([clazz isSubclassOfClass:[DIMMessagePacker class]], @"packer error: %@", clazz);
+    return [[clazz alloc] initWithFacebook:_facebook messenger:self];
+}
+
+- (id<DIMProcessor>)createWorkerProcessor {
+    Class clazz = [_processor class];
+    NSAssert([clazz isSubclassOfClass:[DIMMessageProcessor class]], @"processor error: %@", clazz);
+    return [[clazz alloc] initWithFacebook:_facebook messenger:self];
+}
+
 // Override
 - (__kindof id<DIMProcessor>)processor {
-    return _processor;
+    id<DIMProcessor> worker = s_workerProcessor;
+    return worker ? worker : _processor;
 }
 
 - (void)setProcessor:(id<DIMProcessor>)messageProcessor {
     _processor = messageProcessor;
 }
 
+- (NSUInteger)droppedPackageCount {
+    return atomic_load(&_droppedPackageCount);
+}
+
+- (BOOL)checkEnvelope:(DIMLazyEnvelope *)env package:(NSData *)data {
+    return YES;
+}
+
+// Override
+- (NSArray<NSData *> *)processPackage:(NSData *)data {
+    // scan envelope fields only, so the package can be dropped
+    // before decoding the whole message
+    DIMLazyEnvelope *env = [DIMLazyEnvelope envelopeWithData:data];
+    return [self processPackage:data envelope:env];
+}
+
+// private
+- (NSArray<NSData *> *)processPackage:(NSData *)data envelope:(nullable DIMLazyEnvelope *)env {
+    if (env && ![self checkEnvelope:env package:data]) {
+        atomic_fetch_add(&_droppedPackageCount, 1);
+        return @[];
+    }
+    return [super processPackage:data];
+}
+
+- (NSArray<NSData *> *)processPackage:(NSData *)data accepted:(BOOL *)ok {
+    s_packageAccepted = NO;
+    NSArray<NSData *> *responses = [self processPackage:data];
+    *ok = s_packageAccepted;
+    return responses;
+}
+
+- (NSArray<NSData *> *)processPackage:(NSData *)data
+                             envelope:(nullable DIMLazyEnvelope *)env
+                             accepted:(BOOL *)ok {
+    s_packageAccepted = NO;
+    NSArray<NSData *> *responses = [self processPackage:data envelope:env];
+    *ok = s_packageAccepted;
+    return responses;
+}
+
+- (void)acceptMessage:(id<DKDReliableMessage>)rMsg {
+    s_packageAccepted = YES;
+}
+
 #pragma mark Packer
 
 // Override
@@ -214,6 +350,46 @@
     return [[DIMTransmitterResults alloc] initWithFirst:iMsg second:rMsg];
 }
 
+- (DIMTransmitterResults *)trySendContent:(id<DKDContent>)content
+                                   sender:(nullable id<MKMID>)from
+                                 receiver:(id<MKMID>)to
+                                 priority:(NSInteger)prior {
+    if ([_session respondsToSelector:@selector(isBackpressured)] && [_session isBackpressured]) {
+        // would block
+        return nil;
+    }
+    return [self sendContent:content sender:from receiver:to priority:prior];
+}
+
+- (void)sendContent:(id<DKDContent>)content
+             sender:(nullable id<MKMID>)from
+           receiver:(id<MKMID>)to
+           priority:(NSInteger)prior
+  completionHandler:(void (^)(DIMTransmitterResults *))handler {
+    if (![_session respondsToSelector:@selector(performWhenWritable:cancelHandler:)]) {
+        // the waiting queue is unbounded
+        DIMTransmitterResults *results;
+        results = [self sendContent:content sender:from receiver:to priority:prior];
+        if (handler) {
+            handler(results);
+        }
+        return;
+    }
+    __weak __typeof(self) weakSelf = self;
+    [_session performWhenWritable:^{
+        DIMTransmitterResults *results;
+        results = [weakSelf sendContent:content sender:from receiver:to priority:prior];
+        if (handler) {
+            handler(results);
+        }
+    } cancelHandler:^{
+        NSLog(@"session stopped, failed to send content: %@ => %@", from, to);
+        if (handler) {
+            handler(nil);
+        }
+    }];
+}
+
 // private
 - (BOOL)attachVisaTime:(id<DKDInstantMessage>)iMsg forSender:(id<MKMID>)sender {
     id<DKDContent> content = [iMsg content];
@@ -302,4 +478,23 @@
     return [_session queueMessage:rMsg package:data priority:prior];
 }
 
+- (NSUInteger)sendReliableMessages:(NSArray<id<DKDReliableMessage>> *)messages
+                          packages:(NSArray<NSData *> *)packages
+                          priority:(NSInteger)prior {
+    if ([_session respondsToSelector:@selector(queueMessages:packages:priority:)]) {
+        // put all message packages into the waiting queue in one batch
+        return [_session queueMessages:messages packages:packages priority:prior];
+    }
+    NSUInteger count = 0;
+    NSUInteger total = MIN([messages count], [packages count]);
+    for (NSUInteger index = 0; index < total; ++index) {
+        if ([_session queueMessage:[messages objectAtIndex:index]
+                           package:[packages objectAtIndex:index]
+                          priority:prior]) {
+            ++count;
+        }
+    }
+    return count;
+}
+
 @end
@@ -38,11 +38,41 @@
 #import "DIMMessageUtils.h"
 
 #import "DIMCompatible.h"
+#import "DIMCommonFacebook.h"
 
 #import "DIMCommonPacker.h"
 
+@interface __EncryptKeyRecord : NSObject {
+    
+    @public
+    id<MKEncryptKey> _key;
+    id _signature;  // visa signature
+}
+
+@end
+
+@implementation __EncryptKeyRecord
+
+@end
+
+@interface DIMCommonPacker () {
+    
+    // user ID => (visa signature, public key)
+    id<DIMMemoryCache> _keyCache;
+}
+
+@end
+
 @implementation DIMCommonPacker
 
+- (instancetype)initWithFacebook:(DIMFacebook *)facebook
+                       messenger:(DIMMessenger *)messenger {
+    if (self = [super initWithFacebook:facebook messenger:messenger]) {
+        _keyCache = [[DIMStripedCache alloc] initWithCapacity:4096 stripes:8];
+    }
+    return self;
+}
+
 - (nullable id<DIMArchivist>)archivist {
     DIMFacebook *facebook = [self facebook];
     return [facebook archivist];
@@ -136,15 +166,34 @@
     NSAssert([user isUser], @"user ID error: %@", user);
     DIMFacebook *facebook = [self facebook];
     //return [facebook publicKeyForEncryption:user];
-    NSArray<id<MKMDocument>> *docs = [facebook documentsForID:user];
-    id<MKMVisa> visa = [DIMDocumentUtils lastVisa:docs];
+    id<MKMVisa> visa;
+    if ([facebook isKindOfClass:[DIMCommonFacebook class]]) {
+        // parsed visa cached
+        visa = [(DIMCommonFacebook *)facebook visaForID:user];
+    } else {
+        NSArray<id<MKMDocument>> *docs = [facebook documentsForID:user];
+        visa = [DIMDocumentUtils lastVisa:docs];
+    }
     if (visa) {
-        return [visa publicKey];
+        // the cached key is valid until the visa changed
+        id signature = [visa objectForKey:@"signature"];
+        __EncryptKeyRecord *record = [_keyCache objectForKey:user.string];
+        if (record && signature && [record->_signature isEqual:signature]) {
+            return record->_key;
+        }
+        id<MKEncryptKey> visaKey = [visa publicKey];
+        if (visaKey && signature) {
+            record = [[__EncryptKeyRecord alloc] init];
+            record->_key = visaKey;
+            record->_signature = signature;
+            [_keyCache setObject:record forKey:user.string];
+        }
+        return visaKey;
     }
     id<MKMMeta> meta = [facebook metaForID:user];
     if (meta) {
         id<MKVerifyKey> metaKey = [meta publicKey];
-        if ([meta conformsToProtocol:@protocol(MKEncryptKey)]) {
+        if ([metaKey conformsToProtocol:@protocol(MKEncryptKey)]) {
             return (id<MKEncryptKey>)metaKey;
         }
     }
@@ -35,6 +35,7 @@
 //
 
 #import "DIMCommonFacebook.h"
+#import "DIMCommonMessenger.h"
 
 #import "DIMCommonProcessor.h"
 
@@ -94,6 +95,11 @@
 
 // Override
 - (NSArray<id<DKDContent>> *)processContent:(id<DKDContent>)content withReliableMessageMessage:(id<DKDReliableMessage>)rMsg {
+    // verified & decrypted
+    DIMCommonMessenger *messenger = [self messenger];
+    if ([messenger isKindOfClass:[DIMCommonMessenger class]]) {
+        [messenger acceptMessage:rMsg];
+    }
     NSArray<id<DKDContent>> *responses = [super processContent:content
                                     withReliableMessageMessage:rMsg];
 
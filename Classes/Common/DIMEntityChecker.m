@@ -192,11 +192,15 @@ static inline DIMRecentTimeChecker *_time_checkers(void) {
 }
 
 - (void)setLastActiveMember:(id<MKMID>)member forGroup:(id<MKMID>)gid {
-    [_lastActiveMembers setObject:member forKey:gid];
+    @synchronized (_lastActiveMembers) {
+        [_lastActiveMembers setObject:member forKey:gid];
+    }
 }
 
 - (nullable id<MKMID>)getLastActiveMemberForGroup:(id<MKMID>)gid {
-    return [_lastActiveMembers objectForKey:gid];
+    @synchronized (_lastActiveMembers) {
+        return [_lastActiveMembers objectForKey:gid];
+    }
 }
 
 - (BOOL)checkMembers:(NSArray<id<MKMID>> *)members forGroup:(id<MKMID>)group {
@@ -126,6 +126,48 @@ typedef OKPair<id<DKDInstantMessage>, id<DKDReliableMessage>> DIMTransmitterResu
              package:(NSData *)data
             priority:(NSInteger)prior;
 
+//
+//  Optional, for sessions with a bounded waiting queue;
+//  callers must check 'respondsToSelector:' before calling them
+//
+@optional
+
+/**
+ *  Pack messages into a waiting queue in one batch
+ *
+ * @param messages - network messages
+ * @param packages - serialized messages
+ * @param prior    - priority, smaller is faster
+ * @return count of messages queued
+ */
+- (NSUInteger)queueMessages:(NSArray<id<DKDReliableMessage>> *)messages
+                   packages:(NSArray<NSData *> *)packages
+                   priority:(NSInteger)prior;
+
+/**
+ *  Check whether the waiting queue is full,
+ *  senders should stop queuing more messages when it's backpressured
+ *
+ * @return true when over the high watermark
+ */
+- (BOOL)isBackpressured;
+
+/**
+ *  Call the block when the waiting queue can take more messages
+ *
+ * @param block - job for queuing messages
+ */
+- (void)performWhenWritable:(dispatch_block_t)block;
+
+/**
+ *  Call the block when the waiting queue can take more messages,
+ *  or call the cancel handler when the session stopped before that
+ *
+ * @param block  - job for queuing messages
+ * @param cancel - callback when session stopped
+ */
+- (void)performWhenWritable:(dispatch_block_t)block cancelHandler:(nullable dispatch_block_t)cancel;
+
 @end
 
 NS_ASSUME_NONNULL_END
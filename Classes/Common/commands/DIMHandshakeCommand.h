@@ -41,6 +41,10 @@ NS_ASSUME_NONNULL_BEGIN
 
 #define DKDCommand_Handshake @"handshake"
 
+// transport frame formats
+#define DKDHandshakeFraming_Lines  @"lines"   // JSON lines (default)
+#define DKDHandshakeFraming_Binary @"binary"  // length-prefixed binary frames
+
 typedef NS_ENUM(UInt8, DKDHandshakeState) {
     DKDHandshake_Init,
     DKDHandshake_Start,   // C -> S, without session key(or session expired)
@@ -66,7 +70,9 @@ DKDHandshakeState DKDHandshakeCheckState(NSString *title, NSString *_Nullable se
  *
  *      command : "handshake",    // command name
  *      title   : "Hello world!",
- *      session : "{SESSION_KEY}" // session key
+ *      session : "{SESSION_KEY}", // session key
+ *      framing : ["binary", "lines"] // C -> S: supported frame formats
+ *                                    // S -> C: accepted frame format
  *  }
  */
 @protocol DKDHandshakeCommand <DKDCommand>
@@ -74,6 +80,9 @@ DKDHandshakeState DKDHandshakeCheckState(NSString *title, NSString *_Nullable se
 @property (readonly, strong, nonatomic) NSString *title;
 @property (readonly, strong, nonatomic, nullable) NSString *sessionKey;
 
+// transport frame formats
+@property (readonly, strong, nonatomic, nullable) NSArray<NSString *> *framing;
+
 @property (readonly, nonatomic) DKDHandshakeState state;
 
 @end
@@ -85,6 +94,8 @@ DKDHandshakeState DKDHandshakeCheckState(NSString *title, NSString *_Nullable se
 
 - (instancetype)initWithSessionKey:(nullable NSString *)session;
 
+- (void)setFraming:(nullable NSArray<NSString *> *)framing;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -54,6 +54,8 @@ DKDHandshakeState DKDHandshakeCheckState(NSString *title, NSString *_Nullable se
 @property (strong, nonatomic) NSString *title;
 @property (strong, nonatomic, nullable) NSString *sessionKey;
 
+@property (strong, nonatomic, nullable) NSArray<NSString *> *framing;
+
 @property (nonatomic) DKDHandshakeState state;
 
 @end
@@ -66,6 +68,7 @@ DKDHandshakeState DKDHandshakeCheckState(NSString *title, NSString *_Nullable se
         // lazy
         _title = nil;
         _sessionKey = nil;
+        _framing = nil;
         _state = DKDHandshake_Init;
     }
     return self;
@@ -76,6 +79,7 @@ DKDHandshakeState DKDHandshakeCheckState(NSString *title, NSString *_Nullable se
     if (self = [super initWithType:type]) {
         _title = nil;
         _sessionKey = nil;
+        _framing = nil;
         _state = DKDHandshake_Init;
     }
     return self;
@@ -110,6 +114,7 @@ DKDHandshakeState DKDHandshakeCheckState(NSString *title, NSString *_Nullable se
     if (content) {
         content.title = _title;
         content.sessionKey = _sessionKey;
+        content.framing = _framing;
         content.state = _state;
     }
     return content;
@@ -131,6 +136,26 @@ DKDHandshakeState DKDHandshakeCheckState(NSString *title, NSString *_Nullable se
     return _sessionKey;
 }
 
+// Override
+- (nullable NSArray<NSString *> *)framing {
+    if (!_framing) {
+        id array = [self objectForKey:@"framing"];
+        if ([array isKindOfClass:[NSArray class]]) {
+            _framing = array;
+        }
+    }
+    return _framing;
+}
+
+- (void)setFraming:(nullable NSArray<NSString *> *)framing {
+    if (framing) {
+        [self setObject:framing forKey:@"framing"];
+    } else {
+        [self removeObjectForKey:@"framing"];
+    }
+    _framing = framing;
+}
+
 // Override
 - (DKDHandshakeState)state {
     if (_state == DKDHandshake_Init) {
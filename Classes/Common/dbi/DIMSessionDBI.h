@@ -76,6 +76,9 @@ id<MKMID> DIMGSP(void);  // "gsp@everywhere"
 
 @property (strong, nonatomic, nullable) id<MKMID> provider;
 
+// socket tuning profile for this station, see 'STSocketOptions'
+@property (strong, nonatomic, nullable) NSDictionary *socketOptions;
+
 - (instancetype)initWithID:(nullable id<MKMID>)sid
                     chosen:(NSInteger)order
                       host:(NSString *)IP
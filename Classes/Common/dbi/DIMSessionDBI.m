@@ -143,6 +143,7 @@ id<MKMID> DIMGSP(void) {
     NSString *IP;
     UInt16 port;
     id<MKMID> pid;
+    id options;
     DIMStationInfo *info;
     for (NSDictionary *item in array) {
         sid = MKMIDParse([item objectForKey:@"did"]);
@@ -160,6 +161,10 @@ id<MKMID> DIMGSP(void) {
                                         host:IP
                                         port:port
                                     provider:pid];
+        options = [item objectForKey:@"socket"];
+        if ([options isKindOfClass:[NSDictionary class]]) {
+            info.socketOptions = options;
+        }
         [stations addObject:info];
     }
     return stations;
@@ -167,14 +172,19 @@ id<MKMID> DIMGSP(void) {
 
 + (NSArray<NSDictionary *> *)revert:(NSArray<DIMStationInfo *> *)stations {
     NSMutableArray *array = [[NSMutableArray alloc] initWithCapacity:stations.count];
+    NSMutableDictionary *item;
     for (DIMStationInfo *info in stations) {
-        [array addObject:@{
+        item = [@{
             @"did": [info.identifier string],
             @"chosen": @(info.chosen),
             @"host": [info host],
             @"port": @(info.port),
             @"provider": [info.provider string],
-        }];
+        } mutableCopy];
+        if (info.socketOptions) {
+            [item setObject:info.socketOptions forKey:@"socket"];
+        }
+        [array addObject:item];
     }
     return array;
 }
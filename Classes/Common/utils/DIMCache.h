@@ -46,12 +46,71 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (NSUInteger)reduceMemory;
 
+@optional
+
+- (void)removeObjectForKey:(NSString *)aKey;
+
 @end
 
 @interface DIMThanosCache : NSObject <DIMMemoryCache>
 
 @end
 
+/**
+ *  Bounded Memory Cache
+ *  ~~~~~~~~~~~~~~~~~~~~
+ *
+ *  Evict the least recently used object when the count limit reached,
+ *  and the coldest half when reducing memory; thread safe.
+ */
+@interface DIMLRUCache : NSObject <DIMMemoryCache>
+
+@property(nonatomic, readonly) NSUInteger capacity;
+
+@property(nonatomic, readonly) NSUInteger count;
+
+// statistics
+@property(nonatomic, readonly) NSUInteger hitCount;
+@property(nonatomic, readonly) NSUInteger missCount;
+@property(nonatomic, readonly) NSUInteger evictionCount;
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity NS_DESIGNATED_INITIALIZER;
+
+/**
+ *  Enumerate objects from the least recently used one,
+ *  without changing the order or statistics
+ */
+- (void)enumerateKeysAndObjectsUsingBlock:(void (NS_NOESCAPE ^)(NSString *key, id obj, BOOL *stop))block;
+
+@end
+
+/**
+ *  Striped Memory Cache
+ *  ~~~~~~~~~~~~~~~~~~~~
+ *
+ *  Keys are spread into several LRU caches by hash,
+ *  each one has its own lock, so threads seldom wait for each other.
+ */
+@interface DIMStripedCache : NSObject <DIMMemoryCache>
+
+@property(nonatomic, readonly) NSUInteger count;
+
+// statistics
+@property(nonatomic, readonly) NSUInteger hitCount;
+@property(nonatomic, readonly) NSUInteger missCount;
+@property(nonatomic, readonly) NSUInteger evictionCount;
+
+/**
+ *  Create cache with total capacity
+ *
+ * @param capacity - max count of all objects
+ * @param stripes  - count of LRU caches
+ */
+- (instancetype)initWithCapacity:(NSUInteger)capacity
+                         stripes:(NSUInteger)stripes NS_DESIGNATED_INITIALIZER;
+
+@end
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -60,6 +60,10 @@
     [_caches setObject:anObject forKey:aKey];
 }
 
+- (void)removeObjectForKey:(NSString *)aKey {
+    [_caches removeObjectForKey:aKey];
+}
+
 - (NSUInteger)reduceMemory {
     NSUInteger snap = 0;
     snap = DIMThanos(_caches, snap);
@@ -68,6 +72,283 @@
 
 @end
 
+#pragma mark -
+
+@interface __LRUNode : NSObject {
+    
+    @public
+    NSString *_key;
+    id _value;
+    __unsafe_unretained __LRUNode *_prev;
+    __LRUNode *_next;
+}
+
+@end
+
+@implementation __LRUNode
+
+@end
+
+@interface DIMLRUCache () {
+    
+    NSMutableDictionary<NSString *, __LRUNode *> *_nodes;
+    
+    __LRUNode *_head;  // most recently used
+    __unsafe_unretained __LRUNode *_tail;  // least recently used
+    
+    NSUInteger _hitCount;
+    NSUInteger _missCount;
+    NSUInteger _evictionCount;
+}
+
+@end
+
+@implementation DIMLRUCache
+
+- (instancetype)init {
+    return [self initWithCapacity:1024];
+}
+
+/* designated initializer */
+- (instancetype)initWithCapacity:(NSUInteger)capacity {
+    NSAssert(capacity > 0, @"cache capacity error: %lu", capacity);
+    if (self = [super init]) {
+        _capacity = capacity;
+        _nodes = [[NSMutableDictionary alloc] init];
+        _head = nil;
+        _tail = nil;
+        _hitCount = 0;
+        _missCount = 0;
+        _evictionCount = 0;
+    }
+    return self;
+}
+
+- (NSUInteger)count {
+    @synchronized (self) {
+        return [_nodes count];
+    }
+}
+
+- (NSUInteger)hitCount {
+    @synchronized (self) {
+        return _hitCount;
+    }
+}
+
+- (NSUInteger)missCount {
+    @synchronized (self) {
+        return _missCount;
+    }
+}
+
+- (NSUInteger)evictionCount {
+    @synchronized (self) {
+        return _evictionCount;
+    }
+}
+
+// private
+- (void)detachNode:(__LRUNode *)node {
+    __LRUNode *prev = node->_prev;
+    __LRUNode *next = node->_next;
+    if (prev) {
+        prev->_next = next;
+    } else {
+        _head = next;
+    }
+    if (next) {
+        next->_prev = prev;
+    } else {
+        _tail = prev;
+    }
+    node->_prev = nil;
+    node->_next = nil;
+}
+
+// private
+- (void)attachNode:(__LRUNode *)node {
+    node->_prev = nil;
+    node->_next = _head;
+    if (_head) {
+        _head->_prev = node;
+    } else {
+        _tail = node;
+    }
+    _head = node;
+}
+
+// private
+- (void)evictTail {
+    __LRUNode *node = _tail;
+    if (node) {
+        [_nodes removeObjectForKey:node->_key];
+        [self detachNode:node];
+        ++_evictionCount;
+    }
+}
+
+- (nullable id)objectForKey:(NSString *)aKey {
+    @synchronized (self) {
+        __LRUNode *node = [_nodes objectForKey:aKey];
+        if (!node) {
+            ++_missCount;
+            return nil;
+        }
+        ++_hitCount;
+        if (node != _head) {
+            // move to head
+            [self detachNode:node];
+            [self attachNode:node];
+        }
+        return node->_value;
+    }
+}
+
+- (void)setObject:(id)anObject forKey:(NSString *)aKey {
+    @synchronized (self) {
+        __LRUNode *node = [_nodes objectForKey:aKey];
+        if (node) {
+            // update value and move to head
+            node->_value = anObject;
+            [self detachNode:node];
+            [self attachNode:node];
+            return;
+        }
+        while ([_nodes count] >= _capacity) {
+            [self evictTail];
+        }
+        node = [[__LRUNode alloc] init];
+        node->_key = aKey;
+        node->_value = anObject;
+        [_nodes setObject:node forKey:aKey];
+        [self attachNode:node];
+    }
+}
+
+- (void)removeObjectForKey:(NSString *)aKey {
+    @synchronized (self) {
+        __LRUNode *node = [_nodes objectForKey:aKey];
+        if (node) {
+            [_nodes removeObjectForKey:aKey];
+            [self detachNode:node];
+        }
+    }
+}
+
+- (void)enumerateKeysAndObjectsUsingBlock:(void (NS_NOESCAPE ^)(NSString *key, id obj, BOOL *stop))block {
+    @synchronized (self) {
+        BOOL stop = NO;
+        for (__LRUNode *node = _tail; node && !stop; node = node->_prev) {
+            block(node->_key, node->_value, &stop);
+        }
+    }
+}
+
+- (NSUInteger)reduceMemory {
+    @synchronized (self) {
+        // remove the coldest half
+        NSUInteger survivors = [_nodes count] >> 1;
+        while ([_nodes count] > survivors) {
+            [self evictTail];
+        }
+        return survivors;
+    }
+}
+
+@end
+
+#pragma mark -
+
+@interface DIMStripedCache () {
+    
+    NSArray<DIMLRUCache *> *_stripes;
+}
+
+@end
+
+@implementation DIMStripedCache
+
+- (instancetype)init {
+    return [self initWithCapacity:8192 stripes:8];
+}
+
+/* designated initializer */
+- (instancetype)initWithCapacity:(NSUInteger)capacity stripes:(NSUInteger)stripes {
+    NSAssert(stripes > 0 && capacity >= stripes, @"cache capacity error: %lu, %lu", capacity, stripes);
+    if (self = [super init]) {
+        NSUInteger each = (capacity + stripes - 1) / stripes;
+        NSMutableArray *mArray = [[NSMutableArray alloc] initWithCapacity:stripes];
+        for (NSUInteger i = 0; i < stripes; ++i) {
+            [mArray addObject:[[DIMLRUCache alloc] initWithCapacity:each]];
+        }
+        _stripes = mArray;
+    }
+    return self;
+}
+
+// private
+- (DIMLRUCache *)stripeForKey:(NSString *)aKey {
+    NSUInteger index = [aKey hash] % [_stripes count];
+    return [_stripes objectAtIndex:index];
+}
+
+- (NSUInteger)count {
+    NSUInteger total = 0;
+    for (DIMLRUCache *lru in _stripes) {
+        total += [lru count];
+    }
+    return total;
+}
+
+- (NSUInteger)hitCount {
+    NSUInteger total = 0;
+    for (DIMLRUCache *lru in _stripes) {
+        total += [lru hitCount];
+    }
+    return total;
+}
+
+- (NSUInteger)missCount {
+    NSUInteger total = 0;
+    for (DIMLRUCache *lru in _stripes) {
+        total += [lru missCount];
+    }
+    return total;
+}
+
+- (NSUInteger)evictionCount {
+    NSUInteger total = 0;
+    for (DIMLRUCache *lru in _stripes) {
+        total += [lru evictionCount];
+    }
+    return total;
+}
+
+- (nullable id)objectForKey:(NSString *)aKey {
+    return [[self stripeForKey:aKey] objectForKey:aKey];
+}
+
+- (void)setObject:(id)anObject forKey:(NSString *)aKey {
+    [[self stripeForKey:aKey] setObject:anObject forKey:aKey];
+}
+
+- (void)removeObjectForKey:(NSString *)aKey {
+    [[self stripeForKey:aKey] removeObjectForKey:aKey];
+}
+
+- (NSUInteger)reduceMemory {
+    NSUInteger survivors = 0;
+    for (DIMLRUCache *lru in _stripes) {
+        survivors += [lru reduceMemory];
+    }
+    return survivors;
+}
+
+@end
+
+#pragma mark -
+
 NSUInteger DIMThanos(NSMutableDictionary *planet, NSUInteger finger) {
     NSArray *people = [planet allKeys];
     // if ++finger is odd, remove it,
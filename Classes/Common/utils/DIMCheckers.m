@@ -62,18 +62,22 @@
 
 // private
 - (BOOL)_forceExpired:(NSString *)key timestamp:(NSTimeInterval)now {
-    [_records setObject:@(now + _expires) forKey:key];
+    @synchronized (self) {
+        [_records setObject:@(now + _expires) forKey:key];
+    }
     return YES;
 }
 
 // private
 - (BOOL)_checkExpired:(NSString *)key timestamp:(NSTimeInterval)now {
-    NSNumber *expired = [_records objectForKey:key];
-    if (/*expired && */[expired doubleValue] > now) {
-        // record exists and not expired yet
-        return NO;
+    @synchronized (self) {
+        NSNumber *expired = [_records objectForKey:key];
+        if (/*expired && */[expired doubleValue] > now) {
+            // record exists and not expired yet
+            return NO;
+        }
+        [_records setObject:@(now + _expires) forKey:key];
     }
-    [_records setObject:@(now + _expires) forKey:key];
     return YES;
 }
 
@@ -126,12 +130,14 @@
 
 // private
 - (BOOL)_setLastTime:(NSTimeInterval)now forKey:(NSString *)key {
-    NSNumber *last = [_times objectForKey:key];
-    if (/* !last || */[last doubleValue] < now) {
-        [_times setObject:@(now) forKey:key];
-        return YES;
-    } else {
-        return NO;
+    @synchronized (self) {
+        NSNumber *last = [_times objectForKey:key];
+        if (/* !last || */[last doubleValue] < now) {
+            [_times setObject:@(now) forKey:key];
+            return YES;
+        } else {
+            return NO;
+        }
     }
 }
 
@@ -145,7 +151,10 @@
 
 // private
 - (BOOL)_isExpired:(NSTimeInterval)now forKey:(NSString *)key {
-    NSNumber *last = [_times objectForKey:key];
+    NSNumber *last;
+    @synchronized (self) {
+        last = [_times objectForKey:key];
+    }
     return /*last && */[last doubleValue] > now;
 }
 
@@ -0,0 +1,120 @@
+// license: https://mit-license.org
+//
+//  DIM-SDK : Decentralized Instant Messaging Software Development Kit
+//
+//                               Written in 2026 by agent <agent@local>
+//
+// =============================================================================
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// =============================================================================
+//
+//  DIMDuplicateFilter.h
+//  DIMClient
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ *  Duplicate Filter
+ *  ~~~~~~~~~~~~~~~~
+ *
+ *  Remember signatures of received messages, so the same message pushed
+ *  again (e.g.: the station didn't get our 'SN' response) can be dropped
+ *  before verifying & decrypting.
+ *
+ *  Signatures are recorded in two Bloom filters (current & previous),
+ *  which rotate every 'window' seconds, so a signature is forgotten after
+ *  one or two windows; a 'maybe' answer from the Bloom filters must be
+ *  confirmed by the exact LRU, so a new message will never be dropped
+ *  by false positive.
+ *  The LRU entries will be saved into file, and loaded after restarted.
+ */
+@interface DIMDuplicateFilter : NSObject
+
+@property(nonatomic, readonly, nullable) NSString *path;
+
+// max count of signatures in the exact LRU
+@property(nonatomic, readonly) NSUInteger capacity;
+
+// lifetime of each Bloom generation (default 12 hours)
+@property(nonatomic, readonly) NSTimeInterval window;
+
+// delay for gathering new signatures to save in one time (default 30s)
+@property(nonatomic, assign) NSTimeInterval saveInterval;
+
+// statistics
+@property(nonatomic, readonly) NSUInteger checkCount;      // packages checked
+@property(nonatomic, readonly) NSUInteger duplicateCount;  // packages dropped
+@property(nonatomic, readonly) NSUInteger savedBytes;      // length of packages dropped
+@property(nonatomic, readonly) NSUInteger unconfirmedCount;  // Bloom hits not found in LRU
+
+/**
+ *  Create filter, and load signatures from file
+ *
+ * @param capacity - max count of signatures
+ * @param window   - seconds for rotating Bloom filters
+ * @param path     - file for keeping signatures across restarts
+ */
+- (instancetype)initWithCapacity:(NSUInteger)capacity
+                          window:(NSTimeInterval)window
+                            path:(nullable NSString *)path NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)initWithPath:(nullable NSString *)path;
+
+/**
+ *  Check whether the package with this signature was received before
+ *
+ * @param signature - message signature (base64)
+ * @param length    - package length, for counting saved work
+ * @return YES on duplicated
+ */
+- (BOOL)checkSignature:(NSString *)signature length:(NSUInteger)length;
+
+/**
+ *  Remember signature after the package processed
+ *
+ * @param signature - message signature (base64)
+ */
+- (void)addSignature:(NSString *)signature;
+
+/**
+ *  Write signatures into file now
+ *
+ * @return NO on error
+ */
+- (BOOL)save;
+
+/**
+ *  Get statistics
+ *
+ * @return { count, checked, duplicated, saved_bytes, unconfirmed }
+ */
+- (NSDictionary<NSString *, NSNumber *> *)metrics;
+
+@end
+
+NS_ASSUME_NONNULL_END
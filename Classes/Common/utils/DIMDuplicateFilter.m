@@ -0,0 +1,332 @@
+// license: https://mit-license.org
+//
+//  DIM-SDK : Decentralized Instant Messaging Software Development Kit
+//
+//                               Written in 2026 by agent <agent@local>
+//
+// =============================================================================
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// =============================================================================
+//
+//  DIMDuplicateFilter.m
+//  DIMClient
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import <ObjectKey/ObjectKey.h>
+
+#import "DIMCache.h"
+
+#import "DIMDuplicateFilter.h"
+
+#define DIM_FILTER_VERSION    1
+#define DIM_FILTER_HASHES     7   // ~1% false positive with 10 bits per entry
+#define DIM_FILTER_BITS_EACH  10
+
+// FNV-1a
+static inline UInt64 signature_hash(NSString *signature) {
+    const char *ptr = [signature UTF8String];
+    UInt64 hash = 0xcbf29ce484222325ULL;
+    for (; *ptr; ++ptr) {
+        hash ^= (UInt8)*ptr;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// double hashing: h1 + i * h2
+static inline void bloom_add(NSMutableData *bits, UInt64 hash) {
+    UInt8 *buffer = (UInt8 *)[bits mutableBytes];
+    UInt64 count = (UInt64)[bits length] << 3;
+    UInt64 h1 = hash & 0xFFFFFFFF;
+    UInt64 h2 = (hash >> 32) | 1;
+    UInt64 pos;
+    for (UInt64 i = 0; i < DIM_FILTER_HASHES; ++i) {
+        pos = (h1 + i * h2) % count;
+        buffer[pos >> 3] |= (UInt8)(1 << (pos & 7));
+    }
+}
+
+static inline BOOL bloom_test(NSData *bits, UInt64 hash) {
+    const UInt8 *buffer = (const UInt8 *)[bits bytes];
+    UInt64 count = (UInt64)[bits length] << 3;
+    UInt64 h1 = hash & 0xFFFFFFFF;
+    UInt64 h2 = (hash >> 32) | 1;
+    UInt64 pos;
+    for (UInt64 i = 0; i < DIM_FILTER_HASHES; ++i) {
+        pos = (h1 + i * h2) % count;
+        if ((buffer[pos >> 3] & (1 << (pos & 7))) == 0) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+@interface DIMDuplicateFilter () {
+    
+    DIMLRUCache *_signatures;  // signature => received time
+    
+    NSMutableData *_current;
+    NSMutableData *_previous;
+    NSTimeInterval _rotateTime;  // start time of current generation
+    
+    NSUInteger _checkCount;
+    NSUInteger _duplicateCount;
+    NSUInteger _savedBytes;
+    NSUInteger _unconfirmedCount;
+    
+    BOOL _saveScheduled;
+}
+
+@end
+
+@implementation DIMDuplicateFilter
+
+- (instancetype)init {
+    return [self initWithPath:nil];
+}
+
+- (instancetype)initWithPath:(nullable NSString *)path {
+    return [self initWithCapacity:65536 window:43200 path:path];
+}
+
+/* designated initializer */
+- (instancetype)initWithCapacity:(NSUInteger)capacity
+                          window:(NSTimeInterval)window
+                            path:(nullable NSString *)path {
+    NSAssert(capacity > 0 && window > 0, @"filter params error: %lu, %f", capacity, window);
+    if (self = [super init]) {
+        _path = path;
+        _capacity = capacity;
+        _window = window;
+        _saveInterval = 30;
+        
+        _signatures = [[DIMLRUCache alloc] initWithCapacity:capacity];
+        
+        NSUInteger size = (capacity * DIM_FILTER_BITS_EACH + 7) >> 3;
+        _current = [[NSMutableData alloc] initWithLength:size];
+        _previous = [[NSMutableData alloc] initWithLength:size];
+        _rotateTime = OKGetCurrentTimeInterval();
+        
+        _checkCount = 0;
+        _duplicateCount = 0;
+        _savedBytes = 0;
+        _unconfirmedCount = 0;
+        
+        _saveScheduled = NO;
+        
+        if (path) {
+            [self load];
+        }
+    }
+    return self;
+}
+
+- (NSUInteger)checkCount {
+    @synchronized (self) {
+        return _checkCount;
+    }
+}
+
+- (NSUInteger)duplicateCount {
+    @synchronized (self) {
+        return _duplicateCount;
+    }
+}
+
+- (NSUInteger)savedBytes {
+    @synchronized (self) {
+        return _savedBytes;
+    }
+}
+
+- (NSUInteger)unconfirmedCount {
+    @synchronized (self) {
+        return _unconfirmedCount;
+    }
+}
+
+// private
+- (void)rotateWithTime:(NSTimeInterval)now {
+    if (now - _rotateTime < _window) {
+        return;
+    }
+    if (now - _rotateTime < _window * 2) {
+        // current -> previous
+        NSMutableData *bits = _previous;
+        _previous = _current;
+        _current = bits;
+    } else {
+        // both generations expired
+        [_previous resetBytesInRange:NSMakeRange(0, [_previous length])];
+    }
+    [_current resetBytesInRange:NSMakeRange(0, [_current length])];
+    _rotateTime = now;
+}
+
+- (BOOL)checkSignature:(NSString *)signature length:(NSUInteger)length {
+    NSTimeInterval now = OKGetCurrentTimeInterval();
+    UInt64 hash = signature_hash(signature);
+    @synchronized (self) {
+        ++_checkCount;
+        [self rotateWithTime:now];
+        if (!bloom_test(_current, hash) && !bloom_test(_previous, hash)) {
+            // definitely new
+            return NO;
+        }
+    }
+    // maybe received, confirm with the exact LRU
+    NSNumber *time = [_signatures objectForKey:signature];
+    @synchronized (self) {
+        if (!time || now - [time doubleValue] > _window * 2) {
+            // false positive, or evicted from LRU
+            ++_unconfirmedCount;
+            return NO;
+        }
+        ++_duplicateCount;
+        _savedBytes += length;
+        return YES;
+    }
+}
+
+- (void)addSignature:(NSString *)signature {
+    NSTimeInterval now = OKGetCurrentTimeInterval();
+    UInt64 hash = signature_hash(signature);
+    [_signatures setObject:@(now) forKey:signature];
+    @synchronized (self) {
+        [self rotateWithTime:now];
+        bloom_add(_current, hash);
+        [self scheduleSave];
+    }
+}
+
+// private
+- (void)scheduleSave {
+    if (!_path || _saveScheduled) {
+        // signatures added in this interval will be saved together
+        return;
+    }
+    _saveScheduled = YES;
+    __weak DIMDuplicateFilter *weakSelf = self;
+    dispatch_time_t when = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_saveInterval * NSEC_PER_SEC));
+    dispatch_after(when, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+        [weakSelf save];
+    });
+}
+
+- (BOOL)save {
+    @synchronized (self) {
+        _saveScheduled = NO;
+    }
+    if (!_path) {
+        return NO;
+    }
+    // snapshot from the least recently used one, so the order can be restored
+    NSMutableArray<NSString *> *keys = [[NSMutableArray alloc] initWithCapacity:[_signatures count]];
+    NSMutableArray<NSNumber *> *times = [[NSMutableArray alloc] initWithCapacity:[_signatures count]];
+    [_signatures enumerateKeysAndObjectsUsingBlock:^(NSString *key, id obj, BOOL *stop) {
+        [keys addObject:key];
+        [times addObject:obj];
+    }];
+    NSDictionary *info = @{
+        @"version": @(DIM_FILTER_VERSION),
+        @"signatures": keys,
+        @"times": times,
+    };
+    NSError *error = nil;
+    NSData *data = [NSPropertyListSerialization dataWithPropertyList:info
+                                                              format:NSPropertyListBinaryFormat_v1_0
+                                                             options:0
+                                                               error:&error];
+    if (!data) {
+        NSLog(@"[FILTER] failed to serialize signatures: %@", error);
+        return NO;
+    }
+    if (![data writeToFile:_path options:NSDataWritingAtomic error:&error]) {
+        NSLog(@"[FILTER] failed to save %@: %@", _path, error);
+        return NO;
+    }
+    return YES;
+}
+
+// private
+- (void)load {
+    NSData *data = [NSData dataWithContentsOfFile:_path];
+    if (!data) {
+        // first time
+        return;
+    }
+    NSDictionary *info = [NSPropertyListSerialization propertyListWithData:data
+                                                                   options:NSPropertyListImmutable
+                                                                    format:NULL
+                                                                     error:NULL];
+    if (![info isKindOfClass:[NSDictionary class]] ||
+        [[info objectForKey:@"version"] integerValue] != DIM_FILTER_VERSION) {
+        NSLog(@"[FILTER] ignore signatures file: %@", _path);
+        return;
+    }
+    NSArray<NSString *> *keys = [info objectForKey:@"signatures"];
+    NSArray<NSNumber *> *times = [info objectForKey:@"times"];
+    if (![keys isKindOfClass:[NSArray class]] || ![times isKindOfClass:[NSArray class]] ||
+        [keys count] != [times count]) {
+        NSLog(@"[FILTER] signatures file error: %@", _path);
+        return;
+    }
+    // rebuild the Bloom filters, older ones go to the previous generation
+    NSTimeInterval now = _rotateTime;
+    NSUInteger count = 0;
+    NSString *key;
+    NSTimeInterval time;
+    for (NSUInteger index = 0; index < [keys count]; ++index) {
+        key = [keys objectAtIndex:index];
+        time = [[times objectAtIndex:index] doubleValue];
+        if (now - time > _window * 2) {
+            // expired
+            continue;
+        }
+        [_signatures setObject:@(time) forKey:key];
+        if (now - time > _window) {
+            bloom_add(_previous, signature_hash(key));
+        } else {
+            bloom_add(_current, signature_hash(key));
+        }
+        ++count;
+    }
+    NSLog(@"[FILTER] loaded %lu signature(s), %lu expired", count, [keys count] - count);
+}
+
+- (NSDictionary<NSString *, NSNumber *> *)metrics {
+    NSUInteger count = [_signatures count];
+    @synchronized (self) {
+        return @{
+            @"count": @(count),
+            @"checked": @(_checkCount),
+            @"duplicated": @(_duplicateCount),
+            @"saved_bytes": @(_savedBytes),
+            @"unconfirmed": @(_unconfirmedCount),
+        };
+    }
+}
+
+@end
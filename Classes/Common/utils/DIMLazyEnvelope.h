@@ -0,0 +1,75 @@
+// license: https://mit-license.org
+//
+//  DIM-SDK : Decentralized Instant Messaging Software Development Kit
+//
+//                               Written in 2026 by agent <agent@local>
+//
+// =============================================================================
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// =============================================================================
+//
+//  DIMLazyEnvelope.h
+//  DIMClient
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import <DIMSDK/DIMSDK.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ *  Lazy Envelope
+ *  ~~~~~~~~~~~~~
+ *
+ *  Scan the top level fields of a JSON package for the envelope only,
+ *  the big values ('data', 'key', 'keys', 'meta', 'visa', ...) are skipped
+ *  without decoding, so the package can be checked (duplicated, blocked or
+ *  misrouted) before it's fully deserialized for verifying & decrypting.
+ */
+@interface DIMLazyEnvelope : NSObject
+
+// raw values
+@property(nonatomic, readonly, nullable) NSString *sender;
+@property(nonatomic, readonly, nullable) NSString *receiver;
+@property(nonatomic, readonly, nullable) NSString *group;
+@property(nonatomic, readonly, nullable) NSString *signature;
+@property(nonatomic, readonly, nullable) id sn;
+@property(nonatomic, readonly, nullable) id type;
+
+// parsed when first accessed
+@property(nonatomic, readonly, nullable) id<MKMID> senderID;
+@property(nonatomic, readonly, nullable) id<MKMID> receiverID;
+@property(nonatomic, readonly, nullable) id<MKMID> groupID;
+
+/**
+ *  Scan envelope fields from package
+ *
+ * @param data - JSON object
+ * @return nil when it's not a JSON object, or sender/receiver not found
+ */
++ (nullable instancetype)envelopeWithData:(NSData *)data;
+
+@end
+
+NS_ASSUME_NONNULL_END
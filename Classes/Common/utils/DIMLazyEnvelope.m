@@ -0,0 +1,249 @@
+// license: https://mit-license.org
+//
+//  DIM-SDK : Decentralized Instant Messaging Software Development Kit
+//
+//                               Written in 2026 by agent <agent@local>
+//
+// =============================================================================
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// =============================================================================
+//
+//  DIMLazyEnvelope.m
+//  DIMClient
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import "DIMLazyEnvelope.h"
+
+static inline NSUInteger skip_spaces(const UInt8 *buffer, NSUInteger pos, NSUInteger length) {
+    while (pos < length && (buffer[pos] == ' ' || buffer[pos] == '\t' ||
+                            buffer[pos] == '\r' || buffer[pos] == '\n')) {
+        ++pos;
+    }
+    return pos;
+}
+
+// 'pos' points to the opening quote, return position after the closing quote
+static inline NSUInteger skip_string(const UInt8 *buffer, NSUInteger pos, NSUInteger length,
+                                     BOOL *escaped) {
+    for (++pos; pos < length; ++pos) {
+        if (buffer[pos] == '\\') {
+            *escaped = YES;
+            ++pos;
+        } else if (buffer[pos] == '"') {
+            return pos + 1;
+        }
+    }
+    return NSNotFound;
+}
+
+// return position after the value
+static inline NSUInteger skip_value(const UInt8 *buffer, NSUInteger pos, NSUInteger length) {
+    BOOL escaped = NO;
+    if (buffer[pos] == '"') {
+        return skip_string(buffer, pos, length, &escaped);
+    }
+    NSUInteger depth = 0;
+    UInt8 ch;
+    for (; pos < length; ++pos) {
+        ch = buffer[pos];
+        if (ch == '"') {
+            pos = skip_string(buffer, pos, length, &escaped);
+            if (pos == NSNotFound) {
+                return NSNotFound;
+            }
+            --pos;
+        } else if (ch == '{' || ch == '[') {
+            ++depth;
+        } else if (ch == '}' || ch == ']') {
+            if (depth == 0) {
+                // end of the parent object
+                return pos;
+            } else if (--depth == 0) {
+                return pos + 1;
+            }
+        } else if (depth == 0 && (ch == ',' || ch == ' ' || ch == '\r' || ch == '\n' || ch == '\t')) {
+            // end of number/literal
+            return pos;
+        }
+    }
+    return depth == 0 ? pos : NSNotFound;
+}
+
+static inline BOOL key_equals(const UInt8 *key, NSUInteger len, const char *name) {
+    return len == strlen(name) && memcmp(key, name, len) == 0;
+}
+
+// decode string/number value
+static inline id decode_value(const UInt8 *buffer, NSUInteger start, NSUInteger end, BOOL escaped) {
+    if (buffer[start] == '"') {
+        if (!escaped) {
+            return [[NSString alloc] initWithBytes:(buffer + start + 1)
+                                            length:(end - start - 2)
+                                          encoding:NSUTF8StringEncoding];
+        }
+        // rare case, e.g.: "\/" in base64
+        NSData *data = [NSData dataWithBytesNoCopy:(void *)(buffer + start)
+                                            length:(end - start)
+                                      freeWhenDone:NO];
+        return [NSJSONSerialization JSONObjectWithData:data
+                                               options:NSJSONReadingFragmentsAllowed
+                                                 error:nil];
+    }
+    UInt8 ch = buffer[start];
+    if (ch != '-' && (ch < '0' || ch > '9')) {
+        // object, array or literal
+        return nil;
+    }
+    char tmp[32];
+    NSUInteger len = end - start;
+    if (len >= sizeof(tmp)) {
+        return nil;
+    }
+    memcpy(tmp, buffer + start, len);
+    tmp[len] = '\0';
+    if (memchr(tmp, '.', len) || memchr(tmp, 'e', len) || memchr(tmp, 'E', len)) {
+        return @(strtod(tmp, NULL));
+    }
+    return @(strtoll(tmp, NULL, 10));
+}
+
+@interface DIMLazyEnvelope () {
+    
+    id<MKMID> _senderID;
+    id<MKMID> _receiverID;
+    id<MKMID> _groupID;
+}
+
+@property(nonatomic, strong, nullable) NSString *sender;
+@property(nonatomic, strong, nullable) NSString *receiver;
+@property(nonatomic, strong, nullable) NSString *group;
+@property(nonatomic, strong, nullable) NSString *signature;
+@property(nonatomic, strong, nullable) id sn;
+@property(nonatomic, strong, nullable) id type;
+
+@end
+
+@implementation DIMLazyEnvelope
+
++ (instancetype)envelopeWithData:(NSData *)data {
+    const UInt8 *buffer = [data bytes];
+    NSUInteger length = [data length];
+    NSUInteger pos = skip_spaces(buffer, 0, length);
+    if (pos >= length || buffer[pos] != '{') {
+        // not a JSON object
+        return nil;
+    }
+    DIMLazyEnvelope *env = [[DIMLazyEnvelope alloc] init];
+    NSUInteger keyStart, keyEnd, valueStart, valueEnd;
+    BOOL escaped;
+    id value;
+    for (pos = skip_spaces(buffer, pos + 1, length); pos < length; ) {
+        if (buffer[pos] == '}') {
+            break;
+        } else if (buffer[pos] != '"') {
+            return nil;
+        }
+        // 1. key
+        escaped = NO;
+        keyStart = pos + 1;
+        pos = skip_string(buffer, pos, length, &escaped);
+        if (pos == NSNotFound) {
+            return nil;
+        }
+        keyEnd = pos - 1;
+        pos = skip_spaces(buffer, pos, length);
+        if (pos >= length || buffer[pos] != ':') {
+            return nil;
+        }
+        // 2. value
+        valueStart = skip_spaces(buffer, pos + 1, length);
+        if (valueStart >= length) {
+            return nil;
+        }
+        escaped = NO;
+        if (buffer[valueStart] == '"') {
+            valueEnd = skip_string(buffer, valueStart, length, &escaped);
+        } else {
+            valueEnd = skip_value(buffer, valueStart, length);
+        }
+        if (valueEnd == NSNotFound) {
+            return nil;
+        }
+        [env setValueWithKey:(buffer + keyStart) length:(keyEnd - keyStart)
+                      buffer:buffer start:valueStart end:valueEnd escaped:escaped];
+        // 3. next
+        pos = skip_spaces(buffer, valueEnd, length);
+        if (pos < length && buffer[pos] == ',') {
+            pos = skip_spaces(buffer, pos + 1, length);
+        }
+    }
+    if (!env.sender || !env.receiver) {
+        return nil;
+    }
+    return env;
+}
+
+// private
+- (void)setValueWithKey:(const UInt8 *)key length:(NSUInteger)len
+                 buffer:(const UInt8 *)buffer start:(NSUInteger)start end:(NSUInteger)end
+                escaped:(BOOL)escaped {
+    if (key_equals(key, len, "sender")) {
+        _sender = decode_value(buffer, start, end, escaped);
+    } else if (key_equals(key, len, "receiver")) {
+        _receiver = decode_value(buffer, start, end, escaped);
+    } else if (key_equals(key, len, "group")) {
+        _group = decode_value(buffer, start, end, escaped);
+    } else if (key_equals(key, len, "signature")) {
+        _signature = decode_value(buffer, start, end, escaped);
+    } else if (key_equals(key, len, "sn")) {
+        _sn = decode_value(buffer, start, end, escaped);
+    } else if (key_equals(key, len, "type")) {
+        _type = decode_value(buffer, start, end, escaped);
+    }
+    // other values are skipped
+}
+
+- (id<MKMID>)senderID {
+    if (!_senderID && _sender) {
+        _senderID = MKMIDParse(_sender);
+    }
+    return _senderID;
+}
+
+- (id<MKMID>)receiverID {
+    if (!_receiverID && _receiver) {
+        _receiverID = MKMIDParse(_receiver);
+    }
+    return _receiverID;
+}
+
+- (id<MKMID>)groupID {
+    if (!_groupID && _group) {
+        _groupID = MKMIDParse(_group);
+    }
+    return _groupID;
+}
+
+@end
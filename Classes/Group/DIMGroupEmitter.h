@@ -62,6 +62,27 @@ NS_ASSUME_NONNULL_BEGIN
 //
 #define DIM_SECRET_GROUP_LIMIT 16
 
+// NOTICE: split messages are encrypted & signed by a bounded pool of workers
+//
+//      each member is bound to one worker (by hashing its ID), so messages
+//      for the same receiver are always packed in the order they were sent,
+//      while messages for different receivers are packed concurrently;
+//      every worker packs messages with its own packer.
+//
+#define DIM_GROUP_EMITTER_WORKERS 4  // max, not more than active processors
+
+// max seconds to wait for the workers when sending synchronously
+#define DIM_GROUP_EMITTER_TIMEOUT 60
+
+/**
+ *  Callback for sending group message asynchronously
+ *
+ * @param rMsg    - the dispersed message; nil for tiny group
+ * @param success - count of split messages sent
+ */
+typedef void (^DIMGroupEmitterCompletionHandler)(id<DKDReliableMessage> _Nullable rMsg,
+                                                 NSUInteger success);
+
 @interface DIMGroupEmitter : DIMTripletsHelper
 
 @property (readonly, strong, nonatomic) DIMGroupPacker *packer;
@@ -69,9 +90,28 @@ NS_ASSUME_NONNULL_BEGIN
 // protected, override for customized packer
 - (DIMGroupPacker *)createPacker;
 
+/**
+ *  Create packer for a worker to encrypt & sign split messages,
+ *  default is the same kind as the messenger's packer
+ */
+// protected
+- (id<DIMPacker>)createMessagePacker;
+
 - (id<DKDReliableMessage>)sendInstantMessage:(id<DKDInstantMessage>)iMsg
                                     priority:(NSInteger)prior;
 
+/**
+ *  Send group message in background,
+ *  the handler will be called on main thread after all split messages sent
+ *
+ * @param iMsg    - group message
+ * @param prior   - outgoing priority
+ * @param handler - completion callback
+ */
+- (void)sendInstantMessage:(id<DKDInstantMessage>)iMsg
+                  priority:(NSInteger)prior
+         completionHandler:(nullable DIMGroupEmitterCompletionHandler)handler;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -34,12 +34,104 @@
 //  Created by Albert Moky on 2023/12/13.
 //
 
+#import <stdatomic.h>
+
+#import "NSObject+Threading.h"
+
 #import "DIMGroupEmitter.h"
 
+@interface __FanOutResult : NSObject {
+    
+    @public
+    NSUInteger _success;
+}
+
+@end
+
+@implementation __FanOutResult
+
+@end
+
+@interface __EmitterWorker : NSObject {
+    
+    @public
+    dispatch_queue_t _lane;
+    id<DIMPacker> _packer;  // created on the lane
+}
+
+@end
+
+@implementation __EmitterWorker
+
+@end
+
+@interface __LanePause : NSObject {
+    
+    @public
+    dispatch_queue_t _lane;
+    atomic_bool _resumed;
+}
+
+@end
+
+@implementation __LanePause
+
+@end
+
+static inline NSArray<__EmitterWorker *> *create_workers(NSUInteger count) {
+    dispatch_queue_attr_t attr;
+    attr = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL,
+                                                   QOS_CLASS_UTILITY, 0);
+    NSMutableArray *workers = [[NSMutableArray alloc] initWithCapacity:count];
+    __EmitterWorker *worker;
+    for (NSUInteger index = 0; index < count; ++index) {
+        worker = [[__EmitterWorker alloc] init];
+        worker->_lane = dispatch_queue_create("chat.dim.group.emitter", attr);
+        [workers addObject:worker];
+    }
+    return workers;
+}
+
+// resume once, by whichever comes first
+static inline void resume_lane(__LanePause *pause) {
+    if (!atomic_exchange(&pause->_resumed, true)) {
+        dispatch_resume(pause->_lane);
+    }
+}
+
+// called on the lane: stop the lane after current block, until the session
+// queue can take more messages; no thread will be blocked while waiting
+static inline void pause_until_writable(dispatch_queue_t lane, id<DIMSession> session) {
+    if (![session respondsToSelector:@selector(isBackpressured)] ||
+        ![session respondsToSelector:@selector(performWhenWritable:cancelHandler:)] ||
+        ![session isBackpressured]) {
+        return;
+    }
+    __LanePause *pause = [[__LanePause alloc] init];
+    pause->_lane = lane;
+    atomic_init(&pause->_resumed, false);
+    dispatch_suspend(lane);
+    [session performWhenWritable:^{
+        resume_lane(pause);
+    } cancelHandler:^{
+        // session stopped, let the rest fail
+        resume_lane(pause);
+    }];
+    // don't stop the lane forever if the session hangs
+    dispatch_time_t timeout = dispatch_time(DISPATCH_TIME_NOW,
+                                            DIM_GROUP_EMITTER_TIMEOUT * NSEC_PER_SEC);
+    dispatch_after(timeout, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        resume_lane(pause);
+    });
+}
+
 @interface DIMGroupEmitter ()
 
 @property (strong, nonatomic) DIMGroupPacker *packer;
 
+// serial queues with their own packers for encrypting & signing split messages
+@property (strong, nonatomic) NSArray<__EmitterWorker *> *workers;
+
 @end
 
 @implementation DIMGroupEmitter
@@ -47,6 +139,9 @@
 - (instancetype)initWithDelegate:(DIMGroupDelegate *)delegate {
     if (self = [super initWithDelegate:delegate]) {
         self.packer = [self createPacker];
+        NSUInteger count = [[NSProcessInfo processInfo] activeProcessorCount];
+        count = MAX(1, MIN(count, DIM_GROUP_EMITTER_WORKERS));
+        self.workers = create_workers(count);
     }
     return self;
 }
@@ -55,6 +150,13 @@
     return [[DIMGroupPacker alloc] initWithDelegate:self.delegate];
 }
 
+- (id<DIMPacker>)createMessagePacker {
+    DIMCommonMessenger *messenger = [self messenger];
+    Class clazz = [[messenger packer] class];
+    NSAssert([clazz isSubclassOfClass:[DIMMessagePacker class]], @"packer error: %@", clazz);
+    return [[clazz alloc] initWithFacebook:[self facebook] messenger:messenger];
+}
+
 // private
 - (void)attachGroupTimes:(id<DKDInstantMessage>)iMsg forGroup:(id<MKMID>)gid {
     if ([iMsg.content conformsToProtocol:@protocol(DKDGroupCommand)]) {
@@ -82,8 +184,8 @@
     }
 }
 
-- (id<DKDReliableMessage>)sendInstantMessage:(id<DKDInstantMessage>)iMsg
-                                    priority:(NSInteger)prior {
+// private
+- (nullable NSArray<id<MKMID>> *)_prepareMessage:(id<DKDInstantMessage>)iMsg {
     id<DKDContent> content = [iMsg content];
     id<MKMID> group = [content group];
     if (!group) {
@@ -106,11 +208,21 @@
     //  check group members
     //
     NSArray<id<MKMID>> *members = [self.delegate membersOfGroup:group];
-    NSUInteger count = [members count];
-    if (count == 0) {
+    if ([members count] == 0) {
         NSAssert(false, @"failed to get members for group: %@", group);
         return nil;
     }
+    return members;
+}
+
+- (id<DKDReliableMessage>)sendInstantMessage:(id<DKDInstantMessage>)iMsg
+                                    priority:(NSInteger)prior {
+    NSArray<id<MKMID>> *members = [self _prepareMessage:iMsg];
+    if (!members) {
+        return nil;
+    }
+    id<MKMID> group = [iMsg.content group];
+    NSUInteger count = [members count];
     // no 'assistants' found in group's bulletin document?
     // split group messages and send to all members one by one
     if (count < DIM_SECRET_GROUP_LIMIT) {
@@ -129,7 +241,62 @@
         return [self _disperseMessage:iMsg
                               members:members
                                 group:group
-                             priority:prior];
+                             priority:prior
+                              success:NULL];
+    }
+}
+
+- (void)sendInstantMessage:(id<DKDInstantMessage>)iMsg
+                  priority:(NSInteger)prior
+         completionHandler:(DIMGroupEmitterCompletionHandler)handler {
+    [NSObject performBlockInBackground:^{
+        [self _sendInstantMessage:iMsg priority:prior completionHandler:handler];
+    }];
+}
+
+// private
+- (void)_sendInstantMessage:(id<DKDInstantMessage>)iMsg
+                   priority:(NSInteger)prior
+          completionHandler:(DIMGroupEmitterCompletionHandler)handler {
+    NSArray<id<MKMID>> *members = [self _prepareMessage:iMsg];
+    if (!members) {
+        if (handler) {
+            [NSObject performBlockOnMainThread:^{
+                handler(nil, 0);
+            } waitUntilDone:NO];
+        }
+        return;
+    }
+    id<MKMID> group = [iMsg.content group];
+    NSUInteger count = [members count];
+    if (count < DIM_SECRET_GROUP_LIMIT) {
+        // it is a tiny group, split messages will be sent by the workers,
+        // no need to wait for them here
+        __FanOutResult *result = [[__FanOutResult alloc] init];
+        dispatch_group_t tasks = [self _fanOutMessage:iMsg
+                                              members:members
+                                                group:group
+                                             priority:prior
+                                               result:result];
+        dispatch_group_notify(tasks, dispatch_get_main_queue(), ^{
+            NSLog(@"split %lu message(s) for group: %@", result->_success, group);
+            if (handler) {
+                handler(nil, result->_success);
+            }
+        });
+    } else {
+        NSLog(@"splitting message for %lu members of group: %@", count, group);
+        NSUInteger success = 0;
+        id<DKDReliableMessage> rMsg = [self _disperseMessage:iMsg
+                                                     members:members
+                                                       group:group
+                                                    priority:prior
+                                                     success:&success];
+        if (handler) {
+            [NSObject performBlockOnMainThread:^{
+                handler(rMsg, success);
+            } waitUntilDone:NO];
+        }
     }
 }
 
@@ -139,7 +306,8 @@
 - (id<DKDReliableMessage>)_disperseMessage:(id<DKDInstantMessage>)iMsg
                                    members:(NSArray<id<MKMID>> *)allMembers
                                      group:(id<MKMID>)gid
-                                  priority:(NSInteger)prior {
+                                  priority:(NSInteger)prior
+                                   success:(nullable NSUInteger *)count {
     NSAssert([gid isGroup], @"group ID error: %@", gid);
     //NSAssert(![iMsg objectForKey:@"group"], @"should not happen");
     DIMCommonMessenger *messenger = [self messenger];
@@ -169,21 +337,40 @@
     //
     NSArray<id<DKDReliableMessage>> *messages;
     messages = [self.packer splitReliableMessage:rMsg members:allMembers];
+    NSMutableArray<id<DKDReliableMessage>> *outgoing;
+    outgoing = [[NSMutableArray alloc] initWithCapacity:[messages count]];
     id<MKMID> receiver;
-    BOOL ok;
     for (id<DKDReliableMessage> msg in messages) {
         receiver = [msg receiver];
         if ([sender isEqual:receiver]) {
             NSAssert(false, @"cycled message: %@ => %@, %@", sender, receiver, gid);
             continue;
         }
-        //
-        //  2. send message
-        //
-        ok = [messenger sendReliableMessage:rMsg priority:prior];
-        NSAssert(ok, @"failed to send message: %@ => %@, %@", sender, receiver, gid);
+        [outgoing addObject:msg];
+    }
+    
+    //
+    //  2. serialize the shared body once, attach 'receiver' & 'key' for each
+    //
+    NSArray<NSData *> *packages;
+    packages = [self.packer serializeMessages:outgoing withSharedBody:rMsg];
+    if ([packages count] != [outgoing count]) {
+        NSAssert(false, @"failed to serialize messages: %@ => %@", sender, gid);
+        return nil;
     }
     
+    //
+    //  3. send all messages in one batch
+    //
+    NSUInteger success = [messenger sendReliableMessages:outgoing
+                                                packages:packages
+                                                priority:prior];
+    NSAssert(success == [outgoing count], @"failed to send messages: %lu/%lu, %@",
+             success, [outgoing count], gid);
+    
+    if (count) {
+        *count = success;
+    }
     return rMsg;
 }
 
@@ -194,6 +381,34 @@
                           members:(NSArray<id<MKMID>> *)allMembers
                             group:(id<MKMID>)gid
                          priority:(NSInteger)prior {
+    __FanOutResult *result = [[__FanOutResult alloc] init];
+    dispatch_group_t tasks = [self _fanOutMessage:iMsg
+                                          members:allMembers
+                                            group:gid
+                                         priority:prior
+                                           result:result];
+    // wait for all workers, but not forever
+    dispatch_time_t timeout = dispatch_time(DISPATCH_TIME_NOW,
+                                            DIM_GROUP_EMITTER_TIMEOUT * NSEC_PER_SEC);
+    if (dispatch_group_wait(tasks, timeout) != 0) {
+        NSLog(@"group message not finished in %d seconds: %@", DIM_GROUP_EMITTER_TIMEOUT, gid);
+    }
+    @synchronized (result) {
+        return result->_success;
+    }
+}
+
+/**
+ *  Split group message, then encrypt & sign for each member concurrently
+ *
+ * @param result - counter of split messages sent
+ * @return task group for waiting
+ */
+- (dispatch_group_t)_fanOutMessage:(id<DKDInstantMessage>)iMsg
+                           members:(NSArray<id<MKMID>> *)allMembers
+                             group:(id<MKMID>)gid
+                          priority:(NSInteger)prior
+                            result:(__FanOutResult *)result {
     NSAssert([gid isGroup], @"group ID error: %@", gid);
     NSAssert(![iMsg objectForKey:@"group"], @"should not happen");
     DIMCommonMessenger *messenger = [self messenger];
@@ -206,34 +421,52 @@
     //         they can get the group ID after decrypted.
     
     id<MKMID> sender = [iMsg sender];
-    NSUInteger success = 0;
+    dispatch_group_t tasks = dispatch_group_create();
     
     //
     //  1. split messages
     //
     NSArray<id<DKDInstantMessage>> *messages;
     messages = [self.packer splitInstantMessage:iMsg members:allMembers];
+    NSArray<__EmitterWorker *> *workers = [self workers];
     id<MKMID> receiver;
-    id<DKDReliableMessage> rMsg;
+    __EmitterWorker *worker;
     for (id<DKDInstantMessage> msg in messages) {
         receiver = [msg receiver];
         if ([sender isEqual:receiver]) {
             NSAssert(false, @"cycled message: %@ => %@, %@", sender, receiver, gid);
             continue;
         }
-        //
-        //  2. send message
-        //
-        rMsg = [messenger sendInstantMessage:msg priority:prior];
-        if (!rMsg) {
-            NSLog(@"failed to send message: %@ => %@, %@", sender, receiver, gid);
-            continue;
-        }
-        success += 1;
+        // the same receiver always goes to the same worker,
+        // so its messages will be packed in order
+        worker = [workers objectAtIndex:([receiver hash] % [workers count])];
+        dispatch_group_async(tasks, worker->_lane, ^{
+            // hold the next blocks on this lane while the session is full
+            pause_until_writable(worker->_lane, [messenger session]);
+        });
+        dispatch_group_async(tasks, worker->_lane, ^{
+            //
+            //  2. encrypt & sign with the worker's packer, then send message
+            //
+            if (!worker->_packer) {
+                worker->_packer = [self createMessagePacker];
+            }
+            __block id<DKDReliableMessage> rMsg = nil;
+            [messenger performWithPacker:worker->_packer block:^{
+                rMsg = [messenger sendInstantMessage:msg priority:prior];
+            }];
+            if (!rMsg) {
+                NSLog(@"failed to send message: %@ => %@, %@", sender, msg.receiver, gid);
+                return;
+            }
+            @synchronized (result) {
+                result->_success += 1;
+            }
+        });
     }
     
     // done!
-    return success;
+    return tasks;
 }
 
 @end
@@ -54,6 +54,18 @@ NS_ASSUME_NONNULL_BEGIN
 - (NSArray<id<DKDReliableMessage>> *)splitReliableMessage:(id<DKDReliableMessage>)rMsg
                                                   members:(NSArray<id<MKMID>> *)members;
 
+/**
+ *  Serialize split messages for sending,
+ *  the shared body will be serialized only once for all members,
+ *  only 'receiver' & 'key' will be appended for each one
+ *
+ * @param messages - messages split from the same reliable message
+ * @param rMsg     - the encrypted & signed group message
+ * @return packages of the split messages
+ */
+- (NSArray<NSData *> *)serializeMessages:(NSArray<id<DKDReliableMessage>> *)messages
+                          withSharedBody:(id<DKDReliableMessage>)rMsg;
+
 @end
 
 NS_ASSUME_NONNULL_END
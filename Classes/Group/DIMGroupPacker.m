@@ -34,8 +34,27 @@
 //  Created by Albert Moky on 2023/12/13.
 //
 
+#import "DIMCompatible.h"
+
 #import "DIMGroupPacker.h"
 
+// wrap data buffer without copying
+static inline dispatch_data_t wrap_data(NSData *data) {
+    return dispatch_data_create([data bytes], [data length], NULL, ^{
+        [data length];
+    });
+}
+
+// '{"sender":...,"data":...'  +  '{"receiver":...,"key":...}'
+//      => '{"sender":...,"data":...,"receiver":...,"key":...}'
+static inline NSData *join_json(dispatch_data_t head, NSDictionary *fields) {
+    NSMutableData *tail = [MKUTF8Encode(MKJsonMapEncode(fields)) mutableCopy];
+    NSCAssert([tail length] > 2, @"envelope fields error: %@", fields);
+    // replace the leading '{' with ','
+    [tail replaceBytesInRange:NSMakeRange(0, 1) withBytes:","];
+    return (NSData *)dispatch_data_create_concat(head, wrap_data(tail));
+}
+
 @implementation DIMGroupPacker
 
 - (id<DKDReliableMessage>)packMessageWithContent:(id<DKDContent>)content
@@ -147,4 +166,43 @@
     return messages;
 }
 
+- (NSArray<NSData *> *)serializeMessages:(NSArray<id<DKDReliableMessage>> *)messages
+                          withSharedBody:(id<DKDReliableMessage>)rMsg {
+    NSMutableArray *packages = [[NSMutableArray alloc] initWithCapacity:[messages count]];
+    [DIMCompatible fixMetaAttachment:rMsg];
+    [DIMCompatible fixVisaAttachment:rMsg];
+    //
+    //  1. serialize the shared body without 'receiver' & 'keys'
+    //
+    NSMutableDictionary *info = [rMsg copyDictionary:NO];
+    [info removeObjectForKey:@"receiver"];
+    [info removeObjectForKey:@"keys"];
+    [info removeObjectForKey:@"key"];
+    NSData *body = MKUTF8Encode(MKJsonMapEncode(info));
+    NSUInteger length = [body length];
+    const unsigned char *buffer = [body bytes];
+    if (length < 2 || buffer[length - 1] != '}') {
+        NSAssert(false, @"failed to serialize message body: %@", rMsg);
+        return packages;
+    }
+    // cut the tail '}', all packages will share this buffer
+    dispatch_data_t head = dispatch_data_create_subrange(wrap_data(body), 0, length - 1);
+    //
+    //  2. append 'receiver' & 'key' for each member
+    //
+    NSMutableDictionary *fields = [[NSMutableDictionary alloc] initWithCapacity:2];
+    id keyData;  // Base-64
+    for (id<DKDReliableMessage> msg in messages) {
+        [fields setObject:msg.receiver.string forKey:@"receiver"];
+        keyData = [msg objectForKey:@"key"];
+        if (keyData) {
+            [fields setObject:keyData forKey:@"key"];
+        } else {
+            [fields removeObjectForKey:@"key"];
+        }
+        [packages addObject:join_json(head, fields)];
+    }
+    return packages;
+}
+
 @end
@@ -36,6 +36,7 @@
 //
 
 #import <DIMClient/DIMGateKeeper.h>
+#import <DIMClient/DIMOutboxJournal.h>
 #import <DIMClient/DIMSession.h>
 #import <DIMClient/DIMSessionDBI.h>
 #import <DIMClient/DIMCommonMessenger.h>
@@ -49,11 +50,28 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property(nonatomic, weak) DIMCommonMessenger *messenger;
 
+/**
+ *  Journal for keeping outgoing packages across restarts,
+ *  the packages in it will be queued again by 'replayJournal'.
+ */
+@property(nonatomic, strong, nullable) DIMOutboxJournal *journal;
+
 - (instancetype)initWithDatabase:(id<DIMSessionDBI>)db
                    remoteAddress:(id<NIOSocketAddress>)remote
                    socketChannel:(nullable NIOSocketChannel *)sock
 NS_DESIGNATED_INITIALIZER;
 
+/**
+ *  Queue the packages in the journal again, once for each session;
+ *  call it after handshake accepted, so they won't go before it
+ *
+ * @return NO when not connected, try again later
+ */
+- (BOOL)replayJournal;
+
+// protected, return NO for the messages not worth resending after restart
+- (BOOL)shouldJournalMessage:(id<DKDReliableMessage>)rMsg;
+
 @end
 
 NS_ASSUME_NONNULL_END
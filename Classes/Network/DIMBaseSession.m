@@ -40,6 +40,8 @@
 @interface DIMSession () {
     
     id<MKMID> _identifier;
+    
+    BOOL _journalReplayed;
 }
 
 @property(nonatomic, strong) id<DIMSessionDBI> database;
@@ -63,6 +65,8 @@
         self.database = db;
         self.identifier = nil;
         self.messenger = nil;
+        self.journal = nil;
+        _journalReplayed = NO;
     }
     return self;
 }
@@ -95,7 +99,90 @@
 - (BOOL)queueMessage:(id<DKDReliableMessage>)rMsg package:(NSData *)data
             priority:(NSInteger)prior {
     id<STDeparture> ship = [self departureByPackData:data priority:prior];
-    return [self appendReliableMessage:rMsg departureShip:ship];
+    if (!ship) {
+        NSLog(@"failed to pack departure: %@ => %@", rMsg.sender, rMsg.receiver);
+        return NO;
+    }
+    BOOL ok = [self appendReliableMessage:rMsg departureShip:ship];
+    if (ok && [self shouldJournalMessage:rMsg]) {
+        [_journal appendPackage:data priority:prior forKey:[DIMMessageQueue keyForMessage:rMsg]];
+    }
+    return ok;
+}
+
+// Override
+- (NSUInteger)queueMessages:(NSArray<id<DKDReliableMessage>> *)messages
+                   packages:(NSArray<NSData *> *)packages
+                   priority:(NSInteger)prior {
+    NSAssert([messages count] == [packages count], @"packages not match: %lu, %lu",
+             [messages count], [packages count]);
+    NSUInteger total = [packages count];
+    NSMutableArray *accepted = [[NSMutableArray alloc] initWithCapacity:total];
+    NSMutableArray *ships = [[NSMutableArray alloc] initWithCapacity:total];
+    NSMutableArray *datas = [[NSMutableArray alloc] initWithCapacity:total];
+    id<STDeparture> ship;
+    NSData *data;
+    for (NSUInteger index = 0; index < total; ++index) {
+        data = [packages objectAtIndex:index];
+        ship = [self departureByPackData:data priority:prior];
+        if (!ship) {
+            // no docker, the others will fail too
+            NSLog(@"failed to pack departures: %lu/%lu", total - index, total);
+            break;
+        }
+        [accepted addObject:[messages objectAtIndex:index]];
+        [ships addObject:ship];
+        [datas addObject:data];
+    }
+    if ([ships count] == 0) {
+        return 0;
+    }
+    NSUInteger count = [self appendReliableMessages:accepted departureShips:ships];
+    if (count > 0 && _journal) {
+        // duplicated ones will be overwritten by the same keys
+        [accepted enumerateObjectsUsingBlock:^(id<DKDReliableMessage> rMsg, NSUInteger idx, BOOL *stop) {
+            if (![self shouldJournalMessage:rMsg]) {
+                return;
+            }
+            [self->_journal appendPackage:[datas objectAtIndex:idx]
+                                 priority:prior
+                                   forKey:[DIMMessageQueue keyForMessage:rMsg]];
+        }];
+    }
+    return count;
+}
+
+- (BOOL)shouldJournalMessage:(id<DKDReliableMessage>)rMsg {
+    return YES;
+}
+
+- (BOOL)replayJournal {
+    if (_journalReplayed || !_journal) {
+        return YES;
+    }
+    __block BOOL ok = YES;
+    [_journal replay:^(NSString *key, NSData *package, NSInteger priority) {
+        if (!ok) {
+            return;
+        }
+        NSDictionary *info = MKJsonMapDecode(MKUTF8Decode(package));
+        id<DKDReliableMessage> rMsg = DKDReliableMessageParse(info);
+        if (!rMsg) {
+            NSLog(@"[JOURNAL] drop broken package: %@", key);
+            [self->_journal removePackageForKey:key];
+            return;
+        }
+        id<STDeparture> ship = [self departureByPackData:package priority:priority];
+        if (!ship) {
+            // not connected, try again next time
+            ok = NO;
+            return;
+        }
+        // already in the journal, append to the queue only
+        [self appendReliableMessage:rMsg departureShip:ship];
+    }];
+    _journalReplayed = ok;
+    return ok;
 }
 
 //
@@ -131,15 +218,26 @@
 // Override
 - (void)docker:(id<STDocker>)worker sentShip:(id<STDeparture>)departure {
     if ([departure isKindOfClass:[DIMMessageWrapper class]]) {
-        DIMMessageWrapper *wrapper = (DIMMessageWrapper *)departure;
-        id<DKDReliableMessage> rMsg = [wrapper message];
-        if (rMsg) {
-            // remove from database for actual receiver
-            [self removeReliableMessage:rMsg];
+        [self removeWrapper:(DIMMessageWrapper *)departure];
+    } else if ([departure isKindOfClass:[DIMMessageBatch class]]) {
+        // packages of several messages sent with one write
+        DIMMessageBatch *batch = (DIMMessageBatch *)departure;
+        for (DIMMessageWrapper *wrapper in [batch wrappers]) {
+            [self removeWrapper:wrapper];
         }
     }
 }
 
+// private
+- (void)removeWrapper:(DIMMessageWrapper *)wrapper {
+    id<DKDReliableMessage> rMsg = [wrapper message];
+    if (rMsg) {
+        // remove from journal & database for actual receiver
+        [_journal removePackageForKey:[DIMMessageQueue keyForMessage:rMsg]];
+        [self removeReliableMessage:rMsg];
+    }
+}
+
 // private
 - (void)removeReliableMessage:(id<DKDReliableMessage>)rMsg {
     // 0. if session ID is empty, means user not login;
@@ -37,6 +37,7 @@
 
 #import <DIMClient/STCommonGate.h>
 #import <DIMClient/DIMWrapperQueue.h>
+#import <DIMClient/DIMTokenBucket.h>
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -46,6 +47,48 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property(nonatomic, readonly) STCommonGate *gate;
 
+/**
+ *  Max bytes for packing queued messages with the same priority
+ *  into one departure, so they can be sent out with one write
+ *  (default: 16 KB); 0 means sending messages one by one.
+ */
+@property(nonatomic, assign) NSUInteger batchLength;
+
+/**
+ *  Pack outgoing messages into binary frames on current connection,
+ *  turn it on only after the station accepted it while handshaking;
+ *  JSON lines will be used again after reconnected.
+ */
+@property(nonatomic, assign, getter=isBinaryFraming) BOOL binaryFraming;
+
+/**
+ *  Tuning profile for the socket connected to remote address,
+ *  default is 'STSocketOptions.defaultOptions';
+ *  set it before started, it will be applied to the new socket before connecting.
+ */
+@property(nonatomic, strong, nullable) STSocketOptions *socketOptions;
+
+/**
+ *  When there is nothing to do, block on socket readiness and the wakeup
+ *  signal (raised by appending messages) instead of sleeping (default YES);
+ *  the runner still wakes up every 'maxWaitInterval' for checking timers.
+ */
+@property(nonatomic, assign, getter=isEventDriven) BOOL eventDriven;
+
+@property(nonatomic, assign) NSTimeInterval maxWaitInterval;
+
+/**
+ *  Messages waited longer than this will go before the ones with higher
+ *  priorities (still limited by their own buckets), so the slower traffic
+ *  will never be starved (default 2s, 0 to disable)
+ */
+@property(nonatomic, assign) NSTimeInterval agingInterval;
+
+/**
+ *  Wake up the runner to process immediately
+ */
+- (void)wakeUp;
+
 - (instancetype)initWithRemoteAddress:(id<NIOSocketAddress>)remote
                         socketChannel:(NIOSocketChannel *)sock
 NS_DESIGNATED_INITIALIZER;
@@ -59,15 +102,93 @@ NS_DESIGNATED_INITIALIZER;
                              socketChannel:(NIOSocketChannel *)sock
                                   delegate:(id<STConnectionDelegate>)gate;
 
+/**
+ *  Create waiting queue for outgoing messages
+ *
+ *  Default is a 'DIMConcurrentMessageQueue', because messages are queued
+ *  from many threads, so they will never block the gate; override it to
+ *  return a plain 'DIMMessageQueue' if all messages come from one thread.
+ */
+// protected
+- (DIMMessageQueue *)createMessageQueue;
+
 - (BOOL)isActive;
 - (BOOL)setActive:(BOOL)flag time:(NSTimeInterval)when;
 
+/**
+ *  Whether the waiting queue is over its high watermark
+ */
+- (BOOL)isBackpressured;
+
+/**
+ *  Run the block (in background) when the waiting queue dropped under
+ *  its low watermark; the blocks will be called one by one in order,
+ *  and held again when the queue is backpressured by them.
+ *
+ * @param block - job for queuing more messages
+ */
+- (void)performWhenWritable:(dispatch_block_t)block;
+
+/**
+ *  Same as above, the cancel handler will be called (in background)
+ *  instead of the block when the gate keeper stopped before writable.
+ *
+ * @param block  - job for queuing more messages
+ * @param cancel - callback when stopped
+ */
+- (void)performWhenWritable:(dispatch_block_t)block cancelHandler:(nullable dispatch_block_t)cancel;
+
+/**
+ *  Rate limit for the priority class of outgoing messages:
+ *      urgent - priority < STDeparturePriorityNormal
+ *      normal - priority == STDeparturePriorityNormal
+ *      slower - priority > STDeparturePriorityNormal
+ *  all unlimited by default, set the rates to throttle a class
+ *
+ * @param prior - departure priority
+ * @return token bucket for this class
+ */
+- (DIMTokenBucket *)bucketForPriority:(NSInteger)prior;
+
+/**
+ *  Current bucket levels
+ *
+ * @return { "urgent": {...}, "normal": {...}, "slower": {...} }
+ */
+- (NSDictionary<NSString *, NSDictionary *> *)bucketMetrics;
+
+// protected, return nil when no docker for the remote address
+- (nullable id<STDeparture>)departureByPackData:(NSData *)payload priority:(NSInteger)prior;
+
+/**
+ *  Pack more waiting messages with the same priority after this one
+ *
+ * @param wrapper - first message
+ * @return wrapper itself when no more message can be packed
+ */
 // protected
-- (id<STDeparture>)departureByPackData:(NSData *)payload priority:(NSInteger)prior;
+- (id<STDeparture>)batchWithWrapper:(DIMMessageWrapper *)wrapper;
+
+/**
+ *  Move all waiting messages from another gate keeper into this one,
+ *  the serialized packages will be reused (framed again by current docker),
+ *  so no message need to be packed again when switching stations.
+ *
+ *  The messages are taken even when not connected yet, they will be framed
+ *  and put in front of the waiting queue after the docker created.
+ *
+ * @param keeper - the old gate keeper
+ * @return count of messages moved
+ */
+- (NSUInteger)takeOverQueueFromGateKeeper:(DIMGateKeeper *)keeper;
 
 // protected
 - (BOOL)appendReliableMessage:(id<DKDReliableMessage>)rMsg departureShip:(id<STDeparture>)outgo;
 
+// protected
+- (NSUInteger)appendReliableMessages:(NSArray<id<DKDReliableMessage>> *)messages
+                      departureShips:(NSArray<id<STDeparture>> *)ships;
+
 @end
 
 NS_ASSUME_NONNULL_END
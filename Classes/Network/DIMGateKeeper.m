@@ -35,14 +35,143 @@
 //  Copyright © 2023 DIM Group. All rights reserved.
 //
 
+#import <poll.h>
+#import <fcntl.h>
+#import <unistd.h>
+#import <stdatomic.h>
+
+#import "STStreamDeparture.h"
 #import "STStreamDocker.h"
+#import "STStreamFramer.h"
 
 #import "DIMGateKeeper.h"
 
+// wait interval when socket handles not available
+#define DIM_POLL_INTERVAL 0.125
+
+#define DIM_BUCKET_CLASS_COUNT 3  // urgent, normal, slower
+
+static inline NSUInteger bucket_class(NSInteger priority) {
+    if (priority < STDeparturePriorityNormal) {
+        return 0;
+    } else if (priority == STDeparturePriorityNormal) {
+        return 1;
+    } else {
+        return 2;
+    }
+}
+
+static dispatch_data_t separator = nil;
+
+static inline void wakeup_open(int fds[2]) {
+    if (pipe(fds) != 0) {
+        NSLog(@"[GATE] failed to create wakeup pipe: %d", errno);
+        fds[0] = fds[1] = -1;
+        return;
+    }
+    for (int i = 0; i < 2; ++i) {
+        fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+        fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+    }
+}
+
+static inline void wakeup_close(int fds[2]) {
+    for (int i = 0; i < 2; ++i) {
+        if (fds[i] >= 0) {
+            close(fds[i]);
+            fds[i] = -1;
+        }
+    }
+}
+
+static inline void wakeup_drain(int fd) {
+    unsigned char buffer[64];
+    while (read(fd, buffer, sizeof(buffer)) > 0) {
+        // drop signals
+    }
+}
+
+// first byte of the package: '{' for JSON, magic for binary frame, 0 for others
+static inline unsigned char batch_format(NSArray<NSData *> *fragments) {
+    NSData *first = [fragments firstObject];
+    if ([first length] == 0) {
+        return 0;
+    }
+    const unsigned char *buffer = [first bytes];
+    if (buffer[0] == '{' || buffer[0] == STBinaryFrameMagic) {
+        return buffer[0];
+    }
+    return 0;
+}
+
+// gather fragments without copying,
+// JSON packages are separated by '\n', binary frames are joined directly
+static inline dispatch_data_t pack_data(dispatch_data_t chunks, NSArray<NSData *> *fragments,
+                                        unsigned char format) {
+    OKSingletonDispatchOnce(^{
+        separator = dispatch_data_create("\n", 1, NULL, DISPATCH_DATA_DESTRUCTOR_DEFAULT);
+    });
+    if (!chunks) {
+        chunks = dispatch_data_empty;
+    } else if (format == '{') {
+        chunks = dispatch_data_create_concat(chunks, separator);
+    }
+    dispatch_data_t part;
+    for (NSData *fra in fragments) {
+        part = dispatch_data_create([fra bytes], [fra length], NULL, ^{
+            [fra length];
+        });
+        chunks = dispatch_data_create_concat(chunks, part);
+    }
+    return chunks;
+}
+
+// package data in the departure, without binary frame head
+static inline NSData *fetch_payload(NSArray<NSData *> *fragments) {
+    NSData *data;
+    if ([fragments count] == 1) {
+        data = [fragments firstObject];
+    } else {
+        NSMutableData *mData = [[NSMutableData alloc] init];
+        for (NSData *fra in fragments) {
+            [mData appendData:fra];
+        }
+        data = mData;
+    }
+    return [STStreamFramer bodyOfBinaryFrame:data];
+}
+
+@interface __PendingWriter : NSObject {
+    
+    @public
+    dispatch_block_t _block;
+    dispatch_block_t _cancel;
+}
+
+@end
+
+@implementation __PendingWriter
+
+@end
+
 @interface DIMGateKeeper () {
     
     BOOL _active;
     NSTimeInterval _lastActive;  // last update time
+    
+    int _wakeup[2];              // pipe for waking up the runner
+    atomic_bool _signaled;       // wakeup signal not consumed yet
+    
+    DIMTokenBucket *_buckets[DIM_BUCKET_CLASS_COUNT];
+    NSTimeInterval _throttleWait;  // time for throttled buckets to refill
+    
+    NSMutableArray<__PendingWriter *> *_writers;  // waiting for backpressure off
+    dispatch_queue_t _writerQueue;
+    BOOL _writing;
+    BOOL _writersClosed;  // stopped, no more writer will be called
+    
+    // taken over from the old gate keeper, to be packed again when connected
+    NSMutableArray<DIMMessageWrapper *> *_adopted;
 }
 
 @property(nonatomic, strong) id<NIOSocketAddress> remoteAddress;
@@ -68,13 +197,35 @@
     if (self = [super init]) {
         self.remoteAddress = remote;
         self.gate = [self createGateForRemoteAddress:remote socketChannel:sock];
-        self.queue = [DIMMessageQueue queue];
+        self.queue = [self createMessageQueue];
         _active = NO;
         _lastActive = 0;
+        _batchLength = 1 << 14;  // 16 KB
+        _eventDriven = YES;
+        _maxWaitInterval = 1.0;
+        _agingInterval = 2.0;
+        _buckets[0] = [[DIMTokenBucket alloc] initWithBytesPerSecond:0
+                                                   messagesPerSecond:0];
+        _buckets[1] = [[DIMTokenBucket alloc] initWithBytesPerSecond:0
+                                                   messagesPerSecond:0];
+        _buckets[2] = [[DIMTokenBucket alloc] initWithBytesPerSecond:0
+                                                   messagesPerSecond:0];
+        _throttleWait = 0;
+        _writers = [[NSMutableArray alloc] init];
+        _writerQueue = dispatch_queue_create("chat.dim.gate.writers", DISPATCH_QUEUE_SERIAL);
+        _writing = NO;
+        _writersClosed = NO;
+        _adopted = [[NSMutableArray alloc] init];
+        wakeup_open(_wakeup);
+        atomic_init(&_signaled, false);
     }
     return self;
 }
 
+- (void)dealloc {
+    wakeup_close(_wakeup);
+}
+
 - (STCommonGate *)createGateForRemoteAddress:(id<NIOSocketAddress>)remote
                                socketChannel:(NIOSocketChannel *)sock {
     STCommonGate *streamGate;
@@ -99,16 +250,18 @@
     } else {
         // client
         streamHub = [[STStreamClientHub alloc] initWithConnectionDelegate:gate];
-        id<STConnection> conn = [streamHub connectToRemoteAddress:remote
-                                                     localAddress:nil];
-        if (!conn) {
-            NSAssert(false, @"failed to connect remote: %@", remote);
-        }
-        // TODO: reset send buffer size
+        // send/receive buffer sizes must be set before connecting,
+        // so connect it after started, see 'setup'
+        [streamHub setSocketOptions:[STSocketOptions defaultOptions]];
     }
     return streamHub;
 }
 
+- (DIMMessageQueue *)createMessageQueue {
+    // messages are queued from messenger threads & group emitter lanes
+    return [DIMConcurrentMessageQueue queue];
+}
+
 - (BOOL)isActive {
     return _active;
 }
@@ -125,6 +278,7 @@
     }
     _active = flag;
     _lastActive = when;
+    [self wakeUp];
     return YES;
 }
 
@@ -141,12 +295,74 @@
 - (void)stop {
     [super stop];
     [_gate stop];
+    [self wakeUp];
+    // the waiting writers will never be called, cancel them
+    NSArray<__PendingWriter *> *writers;
+    @synchronized (_writers) {
+        _writersClosed = YES;
+        writers = [_writers copy];
+        [_writers removeAllObjects];
+    }
+    [self cancelWriters:writers];
+}
+
+- (void)wakeUp {
+    if (atomic_exchange(&_signaled, true)) {
+        // signaled already
+        return;
+    }
+    unsigned char ch = 1;
+    if (_wakeup[1] >= 0 && write(_wakeup[1], &ch, 1) < 0 && errno != EAGAIN) {
+        NSLog(@"[GATE] failed to wake up: %d", errno);
+    }
+}
+
+// Override
+- (void)idle {
+    if (!_eventDriven || _wakeup[0] < 0) {
+        [super idle];
+        return;
+    }
+    NSArray<NSNumber *> *sockets = [_gate.hub socketDescriptors];
+    NSUInteger count = [sockets count];
+    struct pollfd fds[1 + count];
+    fds[0].fd = _wakeup[0];
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    for (NSUInteger i = 0; i < count; ++i) {
+        fds[1 + i].fd = [[sockets objectAtIndex:i] intValue];
+        fds[1 + i].events = POLLIN;
+        fds[1 + i].revents = 0;
+    }
+    // without socket handles, incoming data can only be found by polling
+    NSTimeInterval timeout = count > 0 ? _maxWaitInterval : MIN(_maxWaitInterval, DIM_POLL_INTERVAL);
+    if (_throttleWait > 0) {
+        // check again when the tokens refilled
+        timeout = MIN(timeout, _throttleWait);
+    }
+    if (poll(fds, (nfds_t)(1 + count), (int)(timeout * 1000)) < 0 && errno != EINTR) {
+        NSLog(@"[GATE] failed to wait for events: %d", errno);
+        [super idle];
+    }
+    // drain before clearing the flag: a signal raised in between keeps
+    // its byte in the pipe, or finds the flag cleared and writes again
+    wakeup_drain(_wakeup[0]);
+    atomic_store(&_signaled, false);
+    // messages appended while the flag was still set didn't signal,
+    // but the runner always processes once more before waiting again;
+    // the ones held by empty buckets are checked after 'throttleWait'
 }
 
 // Override
 - (void)setup {
     [super setup];
     [_gate start];
+    // connect with the socket options set before started
+    id<STConnection> conn = [_gate.hub connectToRemoteAddress:_remoteAddress
+                                                 localAddress:nil];
+    if (!conn) {
+        NSLog(@"[GATE] failed to connect remote: %@", _remoteAddress);
+    }
 }
 
 // Override
@@ -174,13 +390,18 @@
         [_queue purge];
         return NO;
     }
+    // pack the messages taken over before connected, in front of the others
+    [self packAdoptedMessages];
     // get next message
-    DIMMessageWrapper *wrapper = [_queue nextTask];
+    NSTimeInterval now = OKGetCurrentTimeInterval();
+    DIMMessageWrapper *wrapper = [self nextTaskWithTime:now];
     if (!wrapper) {
         // no more task now, purge failed task
         [_queue purge];
         return NO;
     }
+    // the queue is shrinking, let the waiting writers go
+    [self notifyWriters];
     // if msg in this wrapper is null (means sent successfully),
     // it must have bean cleaned already, so iit should not be empty here
     id<DKDReliableMessage> rMsg = [wrapper message];
@@ -189,25 +410,319 @@
         return YES;
     }
     // try to push
-    BOOL ok = [_gate sendShip:wrapper remoteAddress:_remoteAddress localAddress:nil];
+    id<STDeparture> ship = wrapper;
+    if (_batchLength > 0) {
+        ship = [self batchWithWrapper:wrapper];
+    }
+    BOOL ok = [_gate sendShip:ship remoteAddress:_remoteAddress localAddress:nil];
     if (!ok) {
         NSLog(@"gate error, failed to send data");
     }
+    // charge the bucket
+    NSUInteger count = 1;
+    NSUInteger length;
+    if ([ship isKindOfClass:[DIMMessageBatch class]]) {
+        count = [[(DIMMessageBatch *)ship wrappers] count];
+        length = 0;
+        for (NSData *fra in [ship fragments]) {
+            length += [fra length];
+        }
+    } else {
+        length = [wrapper length];
+    }
+    [[self bucketForPriority:[wrapper priority]] consumeBytes:length messages:count];
     return YES;
 }
 
+// private
+- (nullable DIMMessageWrapper *)nextTaskWithTime:(NSTimeInterval)now {
+    DIMMessageWrapper *wrapper = nil;
+    // the filters may check a bucket several times,
+    // remember the throttled ones to count once for this decision
+    __block NSUInteger throttled = 0;
+    BOOL (^available)(DIMMessageWrapper *) = ^BOOL(DIMMessageWrapper *first) {
+        NSUInteger index = bucket_class([first priority]);
+        if ([self->_buckets[index] isAvailable:now]) {
+            return YES;
+        }
+        throttled |= 1 << index;
+        return NO;
+    };
+    // 1. messages waited too long go first
+    if (_agingInterval > 0) {
+        NSTimeInterval expired = now - _agingInterval;
+        wrapper = [_queue nextTaskPassingTest:^BOOL(DIMMessageWrapper *first) {
+            return [first time] < expired && available(first);
+        }];
+    }
+    // 2. the most important one which is not throttled
+    if (!wrapper) {
+        wrapper = [_queue nextTaskPassingTest:available];
+    }
+    // 3. check time for refilling the throttled buckets
+    NSTimeInterval wait = 0, interval;
+    for (NSUInteger i = 0; i < DIM_BUCKET_CLASS_COUNT; ++i) {
+        if (throttled & (1 << i)) {
+            [_buckets[i] countThrottled];
+        }
+        interval = [_buckets[i] waitInterval];
+        if (interval > 0 && (wait <= 0 || interval < wait)) {
+            wait = interval;
+        }
+    }
+    _throttleWait = wait;
+    return wrapper;
+}
+
+- (BOOL)isBackpressured {
+    return [_queue isBackpressured];
+}
+
+- (void)performWhenWritable:(dispatch_block_t)block {
+    [self performWhenWritable:block cancelHandler:nil];
+}
+
+- (void)performWhenWritable:(dispatch_block_t)block cancelHandler:(nullable dispatch_block_t)cancel {
+    __PendingWriter *writer = [[__PendingWriter alloc] init];
+    writer->_block = block;
+    writer->_cancel = cancel;
+    BOOL closed;
+    @synchronized (_writers) {
+        closed = _writersClosed;
+        if (!closed) {
+            [_writers addObject:writer];
+        }
+    }
+    if (closed) {
+        [self cancelWriters:@[writer]];
+    } else {
+        [self notifyWriters];
+    }
+}
+
+// private
+- (void)cancelWriters:(NSArray<__PendingWriter *> *)writers {
+    if ([writers count] == 0) {
+        return;
+    }
+    dispatch_async(_writerQueue, ^{
+        for (__PendingWriter *item in writers) {
+            if (item->_cancel) {
+                item->_cancel();
+            }
+        }
+    });
+}
+
+// private
+- (void)notifyWriters {
+    @synchronized (_writers) {
+        if (_writing || [_writers count] == 0 || [_queue isBackpressured]) {
+            return;
+        }
+        _writing = YES;
+    }
+    dispatch_async(_writerQueue, ^{
+        [self runWriters];
+    });
+}
+
+// private
+- (void)runWriters {
+    __PendingWriter *writer;
+    while (YES) {
+        @synchronized (_writers) {
+            if ([_writers count] == 0 || [_queue isBackpressured]) {
+                // wait for next notifying
+                _writing = NO;
+                return;
+            }
+            writer = [_writers firstObject];
+            [_writers removeObjectAtIndex:0];
+        }
+        writer->_block();
+    }
+}
+
+- (DIMTokenBucket *)bucketForPriority:(NSInteger)prior {
+    return _buckets[bucket_class(prior)];
+}
+
+- (NSDictionary<NSString *, NSDictionary *> *)bucketMetrics {
+    return @{
+        @"urgent": [_buckets[0] metrics],
+        @"normal": [_buckets[1] metrics],
+        @"slower": [_buckets[2] metrics],
+    };
+}
+
+- (STSocketOptions *)socketOptions {
+    return [_gate.hub socketOptions];
+}
+
+- (void)setSocketOptions:(STSocketOptions *)options {
+    [_gate.hub setSocketOptions:options];
+}
+
+- (BOOL)isBinaryFraming {
+    id<STDocker> docker = [_gate dockerWithRemoteAddress:_remoteAddress
+                                            localAddress:nil];
+    if ([docker isKindOfClass:[STStreamDocker class]]) {
+        return [(STStreamDocker *)docker isBinaryFraming];
+    }
+    return NO;
+}
+
+- (void)setBinaryFraming:(BOOL)binaryFraming {
+    id<STDocker> docker = [_gate dockerForAdvanceParty:nil
+                                         remoteAddress:_remoteAddress
+                                          localAddress:nil];
+    NSAssert([docker isKindOfClass:[STStreamDocker class]], @"docker error: %@", docker);
+    [(STStreamDocker *)docker setBinaryFraming:binaryFraming];
+}
+
 - (id<STDeparture>)departureByPackData:(NSData *)payload priority:(NSInteger)prior {
     id<STDocker> docker = [_gate dockerForAdvanceParty:nil
                                          remoteAddress:_remoteAddress
                                           localAddress:nil];
+    if (!docker) {
+        // not connected
+        return nil;
+    }
     NSAssert([docker conformsToProtocol:@protocol(STDeparturePacker)], @"departure packer error: %@", docker);
     id<STDeparturePacker> packer = (id<STDeparturePacker>)docker;
     return [packer departureByPackData:payload priority:prior];
 }
 
+- (id<STDeparture>)batchWithWrapper:(DIMMessageWrapper *)wrapper {
+    NSInteger prior = [wrapper priority];
+    NSUInteger size = [wrapper length];
+    unsigned char format = batch_format([wrapper fragments]);
+    if (size >= _batchLength || format == 0) {
+        return wrapper;
+    }
+    // JSON packages need a '\n' between them
+    NSUInteger gap = (format == '{') ? 1 : 0;
+    NSMutableArray<DIMMessageWrapper *> *wrappers = [[NSMutableArray alloc] init];
+    [wrappers addObject:wrapper];
+    dispatch_data_t chunks = pack_data(nil, [wrapper fragments], format);
+    // 1. get more messages with same priority,
+    //    stop at the first one in another format, so the order is kept
+    DIMMessageWrapper *next;
+    NSUInteger room;
+    while (size + gap < _batchLength) {
+        room = _batchLength - size - gap;
+        next = [_queue nextTaskWithPriority:prior passingTest:^BOOL(DIMMessageWrapper *first) {
+            return [first length] <= room && batch_format([first fragments]) == format;
+        }];
+        if (!next) {
+            break;
+        } else if (![next message]) {
+            // msg sent?
+            continue;
+        }
+        chunks = pack_data(chunks, [next fragments], format);
+        size += gap + [next length];
+        [wrappers addObject:next];
+    }
+    if ([wrappers count] == 1) {
+        return wrapper;
+    }
+    // 2. pack all packages into one departure
+    id<STDeparture> outgo;
+    if (format == STBinaryFrameMagic) {
+        // frames are packed already, join them without framing again
+        outgo = [[STStreamDeparture alloc] initWithData:(NSData *)chunks priority:prior];
+    } else {
+        outgo = [self departureByPackData:(NSData *)chunks priority:prior];
+        if (!outgo) {
+            // disconnected, put back the others in front of the queue,
+            // the first one will be handled by the caller
+            NSRange range = NSMakeRange(1, [wrappers count] - 1);
+            [_queue restoreTasks:[wrappers subarrayWithRange:range]];
+            return wrapper;
+        }
+    }
+    return [[DIMMessageBatch alloc] initWithWrappers:wrappers departureShip:outgo];
+}
+
+- (NSUInteger)takeOverQueueFromGateKeeper:(DIMGateKeeper *)keeper {
+    // take all of them even not connected yet, the old one is stopping;
+    // they will be packed by the runner after the docker created
+    NSArray<DIMMessageWrapper *> *wrappers = [keeper.queue removeAllTasks];
+    NSUInteger count = 0;
+    @synchronized (_adopted) {
+        for (DIMMessageWrapper *item in wrappers) {
+            if ([item message]) {
+                [_adopted addObject:item];
+                ++count;
+            }
+        }
+    }
+    NSLog(@"[GATE] took over %lu/%lu message(s) from %@", count, [wrappers count], keeper.remoteAddress);
+    if (count > 0) {
+        [self wakeUp];
+    }
+    return count;
+}
+
+// private
+- (NSUInteger)packAdoptedMessages {
+    NSArray<DIMMessageWrapper *> *wrappers;
+    @synchronized (_adopted) {
+        if ([_adopted count] == 0) {
+            return 0;
+        }
+        wrappers = [_adopted copy];
+        [_adopted removeAllObjects];
+    }
+    id<STDocker> docker = [_gate dockerWithRemoteAddress:_remoteAddress
+                                            localAddress:nil];
+    if (!docker) {
+        // not connected yet, keep them in order
+        @synchronized (_adopted) {
+            [_adopted insertObjects:wrappers
+                          atIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, [wrappers count])]];
+        }
+        return 0;
+    }
+    NSAssert([docker conformsToProtocol:@protocol(STDeparturePacker)], @"departure packer error: %@", docker);
+    id<STDeparturePacker> packer = (id<STDeparturePacker>)docker;
+    NSMutableArray<DIMMessageWrapper *> *packed;
+    packed = [[NSMutableArray alloc] initWithCapacity:[wrappers count]];
+    NSData *payload;
+    id<STDeparture> ship;
+    for (DIMMessageWrapper *item in wrappers) {
+        // reuse the package, remove the frame head of the old docker
+        payload = fetch_payload([item fragments]);
+        ship = [packer departureByPackData:payload priority:[item priority]];
+        if (ship) {
+            [packed addObject:[[DIMMessageWrapper alloc] initWithReliableMessage:[item message]
+                                                                   departureShip:ship]];
+        }
+    }
+    // they were queued before the ones waiting here
+    NSUInteger count = [_queue restoreTasks:packed];
+    NSLog(@"[GATE] packed %lu/%lu message(s) taken over", count, [wrappers count]);
+    return count;
+}
+
 - (BOOL)appendReliableMessage:(id<DKDReliableMessage>)rMsg
                 departureShip:(id<STDeparture>)outgo {
-    return [_queue appendReliableMessage:rMsg departureShip:outgo];
+    BOOL ok = [_queue appendReliableMessage:rMsg departureShip:outgo];
+    if (ok) {
+        [self wakeUp];
+    }
+    return ok;
+}
+
+- (NSUInteger)appendReliableMessages:(NSArray<id<DKDReliableMessage>> *)messages
+                      departureShips:(NSArray<id<STDeparture>> *)ships {
+    NSUInteger count = [_queue appendReliableMessages:messages departureShips:ships];
+    if (count > 0) {
+        [self wakeUp];
+    }
+    return count;
 }
 
 //
@@ -227,7 +742,7 @@
 
 // Override
 - (void)docker:(id<STDocker>)worker sentShip:(id<STDeparture>)departure {
-    // TODO: remove sent message from local cache
+    // override for removing sent message from local cache
 }
 
 // Override
@@ -0,0 +1,125 @@
+// license: https://mit-license.org
+//
+//  DIM-SDK : Decentralized Instant Messaging Software Development Kit
+//
+//                               Written in 2026 by agent <agent@local>
+//
+// =============================================================================
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// =============================================================================
+//
+//  DIMOutboxJournal.h
+//  DIMClient
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef void (^DIMOutboxJournalReplayHandler)(NSString *key, NSData *package, NSInteger priority);
+
+/**
+ *  Outbox Journal
+ *  ~~~~~~~~~~~~~~
+ *
+ *  Append-only file (memory mapped) for keeping outgoing packages,
+ *  so the queued messages can be sent again after the app restarted.
+ *
+ *      file   : "DIMJ" + version(4) + records...
+ *      record : header(24) + key + payload, aligned to 8 bytes
+ *
+ *  Packages are appended into the mapped pages, and synchronized to disk
+ *  in groups after 'commitInterval'; when a package was sent, a tombstone
+ *  record with the same key will be appended.
+ *  The file will be rewritten in background when most records are dead.
+ *
+ *  Syncing and rewriting run in a background queue, appending only waits
+ *  for taking the range to sync, or for swapping the mapping.
+ */
+@interface DIMOutboxJournal : NSObject
+
+@property(nonatomic, readonly) NSString *path;
+
+// delay for gathering appended records to sync in one time (default 0.05s)
+@property(nonatomic, assign) NSTimeInterval commitInterval;
+
+// packages older than this will not be replayed (default 7 days)
+@property(nonatomic, assign) NSTimeInterval expires;
+
+// compact when dead bytes reach this and half of the file (default 256 KB)
+@property(nonatomic, assign) NSUInteger compactThreshold;
+
+// count of living packages
+@property(nonatomic, readonly) NSUInteger count;
+
+/**
+ *  Open (or create) the journal file
+ *
+ * @param path - file path
+ * @return nil on error
+ */
+- (nullable instancetype)initWithPath:(NSString *)path
+NS_DESIGNATED_INITIALIZER;
+
+/**
+ *  Append outgoing package
+ *
+ * @param package - serialized message
+ * @param prior   - priority of the departure ship
+ * @param key     - index key of the message
+ * @return NO on error
+ */
+- (BOOL)appendPackage:(NSData *)package priority:(NSInteger)prior forKey:(NSString *)key;
+
+/**
+ *  Append a tombstone for the sent package
+ *
+ * @param key - index key of the message
+ */
+- (void)removePackageForKey:(NSString *)key;
+
+/**
+ *  Call the handler with all living packages in appending order,
+ *  the expired ones will be removed
+ *
+ * @return count of packages replayed
+ */
+- (NSUInteger)replay:(NS_NOESCAPE DIMOutboxJournalReplayHandler)handler;
+
+/**
+ *  Sync appended records to disk now, wait until finished
+ */
+- (void)flush;
+
+/**
+ *  Rewrite the file with living records only, wait until finished
+ */
+- (void)compact;
+
+- (void)close;
+
+@end
+
+NS_ASSUME_NONNULL_END
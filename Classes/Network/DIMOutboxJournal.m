@@ -0,0 +1,562 @@
+// license: https://mit-license.org
+//
+//  DIM-SDK : Decentralized Instant Messaging Software Development Kit
+//
+//                               Written in 2026 by agent <agent@local>
+//
+// =============================================================================
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// =============================================================================
+//
+//  DIMOutboxJournal.m
+//  DIMClient
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <fcntl.h>
+#import <unistd.h>
+
+#import <ObjectKey/ObjectKey.h>
+
+#import "DIMOutboxJournal.h"
+
+#define DIM_JOURNAL_MAGIC    "DIMJ"
+#define DIM_JOURNAL_VERSION  1
+#define DIM_JOURNAL_HEAD     8
+#define DIM_JOURNAL_GROWTH   (1 << 20)  // 1 MB
+
+typedef NS_ENUM(UInt8, DIMJournalRecordType) {
+    DIMJournalRecordTypePackage   = 1,
+    DIMJournalRecordTypeTombstone = 2,
+};
+
+typedef struct {
+    UInt8  type;
+    UInt8  reserved;
+    UInt16 keyLength;
+    SInt32 priority;
+    UInt32 length;    // payload length
+    UInt32 checksum;  // FNV-1a of key & payload
+    double time;      // appended time
+} JournalRecord;
+
+static inline size_t align8(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+static inline size_t record_size(const JournalRecord *rec) {
+    return align8(sizeof(JournalRecord) + rec->keyLength + rec->length);
+}
+
+static inline UInt32 fnv1a(UInt32 hash, const void *bytes, size_t length) {
+    const UInt8 *p = bytes;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= p[i];
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+static inline UInt32 record_checksum(const void *key, size_t keyLength,
+                                     const void *payload, size_t length) {
+    UInt32 hash = fnv1a(2166136261, key, keyLength);
+    return fnv1a(hash, payload, length);
+}
+
+// write record at the offset, the buffer must be large enough
+static inline size_t record_write(UInt8 *buffer, DIMJournalRecordType type, NSInteger prior,
+                                  NSData *key, NSData *payload, NSTimeInterval now) {
+    JournalRecord rec;
+    rec.type = type;
+    rec.reserved = 0;
+    rec.keyLength = (UInt16)[key length];
+    rec.priority = (SInt32)prior;
+    rec.length = (UInt32)[payload length];
+    rec.checksum = record_checksum([key bytes], rec.keyLength, [payload bytes], rec.length);
+    rec.time = now;
+    memcpy(buffer, &rec, sizeof(JournalRecord));
+    memcpy(buffer + sizeof(JournalRecord), [key bytes], rec.keyLength);
+    memcpy(buffer + sizeof(JournalRecord) + rec.keyLength, [payload bytes], rec.length);
+    // keep the padding zero
+    size_t size = record_size(&rec);
+    size_t used = sizeof(JournalRecord) + rec.keyLength + rec.length;
+    memset(buffer + used, 0, size - used);
+    return size;
+}
+
+// check the record at the offset, return NULL for the end of journal
+static inline const JournalRecord *record_read(const UInt8 *base, size_t offset, size_t capacity) {
+    if (offset + sizeof(JournalRecord) > capacity) {
+        return NULL;
+    }
+    const JournalRecord *rec = (const JournalRecord *)(base + offset);
+    if (rec->type != DIMJournalRecordTypePackage && rec->type != DIMJournalRecordTypeTombstone) {
+        // zero filled, or broken
+        return NULL;
+    }
+    if (offset + record_size(rec) > capacity) {
+        // torn write
+        return NULL;
+    }
+    const UInt8 *key = base + offset + sizeof(JournalRecord);
+    if (rec->checksum != record_checksum(key, rec->keyLength, key + rec->keyLength, rec->length)) {
+        // torn write
+        return NULL;
+    }
+    return rec;
+}
+
+static inline NSString *record_key(const JournalRecord *rec) {
+    const UInt8 *key = (const UInt8 *)rec + sizeof(JournalRecord);
+    return [[NSString alloc] initWithBytes:key length:rec->keyLength encoding:NSUTF8StringEncoding];
+}
+
+static inline NSData *record_payload(const JournalRecord *rec) {
+    const UInt8 *key = (const UInt8 *)rec + sizeof(JournalRecord);
+    return [[NSData alloc] initWithBytes:(key + rec->keyLength) length:rec->length];
+}
+
+// the mapping may be syncing or compacting in the background queue,
+// so it can only be unmapped after them
+static inline void unmap_later(dispatch_queue_t queue, void *base, size_t size) {
+    dispatch_async(queue, ^{
+        munmap(base, size);
+    });
+}
+
+@interface DIMOutboxJournal () {
+    
+    int _fd;
+    UInt8 *_base;
+    size_t _capacity;
+    size_t _offset;  // end of records
+    size_t _synced;  // records before this were synced to disk
+    size_t _deadBytes;
+    
+    // key => offset of the living package
+    NSMutableDictionary<NSString *, NSNumber *> *_index;
+    
+    dispatch_queue_t _queue;
+    BOOL _commitScheduled;
+    BOOL _compactScheduled;
+}
+
+@property(nonatomic, strong) NSString *path;
+
+@end
+
+@implementation DIMOutboxJournal
+
+- (instancetype)init {
+    NSAssert(false, @"DON'T call me!");
+    NSString *path = nil;
+    return [self initWithPath:path];
+}
+
+/* designated initializer */
+- (instancetype)initWithPath:(NSString *)path {
+    if (self = [super init]) {
+        self.path = path;
+        _fd = -1;
+        _base = NULL;
+        _index = [[NSMutableDictionary alloc] init];
+        _queue = dispatch_queue_create("chat.dim.journal", DISPATCH_QUEUE_SERIAL);
+        _commitScheduled = NO;
+        _compactScheduled = NO;
+        _commitInterval = 0.05;
+        _expires = 3600 * 24 * 7;
+        _compactThreshold = 1 << 18;  // 256 KB
+        if (![self openFile]) {
+            return nil;
+        }
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [self close];
+}
+
+- (NSUInteger)count {
+    @synchronized (self) {
+        return [_index count];
+    }
+}
+
+// private
+- (BOOL)openFile {
+    int fd = open([_path fileSystemRepresentation], O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+        NSLog(@"[JOURNAL] failed to open %@: %d", _path, errno);
+        return NO;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NO;
+    }
+    size_t size = (size_t)st.st_size;
+    size_t capacity = MAX(size, DIM_JOURNAL_GROWTH);
+    if (capacity != size && ftruncate(fd, capacity) != 0) {
+        NSLog(@"[JOURNAL] failed to resize %@: %d", _path, errno);
+        close(fd);
+        return NO;
+    }
+    void *base = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        NSLog(@"[JOURNAL] failed to map %@: %d", _path, errno);
+        close(fd);
+        return NO;
+    }
+    _fd = fd;
+    _base = base;
+    _capacity = capacity;
+    if (size < DIM_JOURNAL_HEAD || memcmp(_base, DIM_JOURNAL_MAGIC, 4) != 0) {
+        // new file
+        UInt32 version = DIM_JOURNAL_VERSION;
+        memcpy(_base, DIM_JOURNAL_MAGIC, 4);
+        memcpy(_base + 4, &version, 4);
+        memset(_base + DIM_JOURNAL_HEAD, 0, _capacity - DIM_JOURNAL_HEAD);
+        _offset = DIM_JOURNAL_HEAD;
+        _synced = 0;
+        _deadBytes = 0;
+        [_index removeAllObjects];
+        return YES;
+    }
+    [self scanRecords];
+    return YES;
+}
+
+// private
+- (void)scanRecords {
+    [_index removeAllObjects];
+    _deadBytes = 0;
+    size_t offset = DIM_JOURNAL_HEAD;
+    const JournalRecord *rec;
+    while ((rec = record_read(_base, offset, _capacity))) {
+        [self indexRecord:rec atOffset:offset];
+        offset += record_size(rec);
+    }
+    // drop the torn tail
+    memset(_base + offset, 0, _capacity - offset);
+    _offset = offset;
+    _synced = offset;
+}
+
+// private
+- (void)indexRecord:(const JournalRecord *)rec atOffset:(size_t)offset {
+    NSString *key = record_key(rec);
+    NSNumber *pos = [_index objectForKey:key];
+    if (pos) {
+        // overwritten or removed
+        _deadBytes += record_size((const JournalRecord *)(_base + [pos unsignedLongValue]));
+        [_index removeObjectForKey:key];
+    }
+    if (rec->type == DIMJournalRecordTypePackage) {
+        [_index setObject:@(offset) forKey:key];
+    } else {
+        _deadBytes += record_size(rec);
+    }
+}
+
+// private
+- (BOOL)reserve:(size_t)size {
+    if (_offset + size <= _capacity) {
+        return YES;
+    }
+    size_t capacity = _capacity;
+    while (_offset + size > capacity) {
+        capacity += DIM_JOURNAL_GROWTH;
+    }
+    if (ftruncate(_fd, capacity) != 0) {
+        NSLog(@"[JOURNAL] failed to grow %@: %d", _path, errno);
+        return NO;
+    }
+    void *base = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (base == MAP_FAILED) {
+        NSLog(@"[JOURNAL] failed to remap %@: %d", _path, errno);
+        return NO;
+    }
+    // both mappings share the same pages of the file,
+    // the records not synced yet will be synced with the new one
+    unmap_later(_queue, _base, _capacity);
+    _base = base;
+    _capacity = capacity;
+    return YES;
+}
+
+// private
+- (BOOL)appendType:(DIMJournalRecordType)type priority:(NSInteger)prior
+               key:(NSString *)key package:(NSData *)payload {
+    NSData *keyData = MKUTF8Encode(key);
+    if ([keyData length] > UINT16_MAX) {
+        NSAssert(false, @"journal key too long: %@", key);
+        return NO;
+    }
+    size_t size = align8(sizeof(JournalRecord) + [keyData length] + [payload length]);
+    @synchronized (self) {
+        if (!_base || ![self reserve:size]) {
+            return NO;
+        }
+        NSNumber *pos = [_index objectForKey:key];
+        if (pos) {
+            _deadBytes += record_size((const JournalRecord *)(_base + [pos unsignedLongValue]));
+            [_index removeObjectForKey:key];
+        }
+        if (type == DIMJournalRecordTypePackage) {
+            [_index setObject:@(_offset) forKey:key];
+        } else {
+            _deadBytes += size;
+        }
+        record_write(_base + _offset, type, prior, keyData, payload, OKGetCurrentTimeInterval());
+        _offset += size;
+        [self scheduleCommit];
+    }
+    return YES;
+}
+
+- (BOOL)appendPackage:(NSData *)package priority:(NSInteger)prior forKey:(NSString *)key {
+    return [self appendType:DIMJournalRecordTypePackage priority:prior key:key package:package];
+}
+
+- (void)removePackageForKey:(NSString *)key {
+    @synchronized (self) {
+        if (![_index objectForKey:key]) {
+            // not found
+            return;
+        }
+    }
+    [self appendType:DIMJournalRecordTypeTombstone priority:0 key:key package:[NSData data]];
+}
+
+- (NSUInteger)replay:(NS_NOESCAPE DIMOutboxJournalReplayHandler)handler {
+    NSMutableArray<NSString *> *keys = [[NSMutableArray alloc] init];
+    NSMutableArray<NSData *> *packages = [[NSMutableArray alloc] init];
+    NSMutableArray<NSNumber *> *priorities = [[NSMutableArray alloc] init];
+    NSMutableArray<NSString *> *expired = [[NSMutableArray alloc] init];
+    NSTimeInterval now = OKGetCurrentTimeInterval();
+    @synchronized (self) {
+        if (!_base) {
+            return 0;
+        }
+        // sort by offset for appending order
+        NSArray<NSString *> *array = [_index keysSortedByValueUsingSelector:@selector(compare:)];
+        const JournalRecord *rec;
+        for (NSString *key in array) {
+            rec = (const JournalRecord *)(_base + [[_index objectForKey:key] unsignedLongValue]);
+            if (rec->time + _expires < now) {
+                [expired addObject:key];
+                continue;
+            }
+            [keys addObject:key];
+            [packages addObject:record_payload(rec)];
+            [priorities addObject:@(rec->priority)];
+        }
+    }
+    for (NSString *key in expired) {
+        [self removePackageForKey:key];
+    }
+    NSUInteger count = [keys count];
+    for (NSUInteger index = 0; index < count; ++index) {
+        handler([keys objectAtIndex:index],
+                [packages objectAtIndex:index],
+                [[priorities objectAtIndex:index] integerValue]);
+    }
+    NSLog(@"[JOURNAL] replayed %lu package(s), %lu expired", count, [expired count]);
+    return count;
+}
+
+// private
+- (void)scheduleCommit {
+    if (_commitScheduled) {
+        // records appended in this interval will be synced together
+        return;
+    }
+    _commitScheduled = YES;
+    dispatch_time_t when = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_commitInterval * NSEC_PER_SEC));
+    dispatch_after(when, _queue, ^{
+        [self commit];
+    });
+}
+
+- (void)flush {
+    dispatch_sync(_queue, ^{
+        [self commit];
+    });
+}
+
+// private, running in the background queue
+- (void)commit {
+    UInt8 *base;
+    size_t start, end;
+    @synchronized (self) {
+        _commitScheduled = NO;
+        if (!_base || _synced >= _offset) {
+            return;
+        }
+        // msync needs page aligned address
+        size_t page = (size_t)getpagesize();
+        base = _base;
+        start = _synced / page * page;
+        end = _offset;
+    }
+    // records before the end will not be changed, and the mapping will not be
+    // unmapped before this finished, so sync them without blocking the appending
+    if (msync(base + start, end - start, MS_SYNC) != 0) {
+        NSLog(@"[JOURNAL] failed to sync %@: %d", _path, errno);
+        return;
+    }
+    @synchronized (self) {
+        if (_base && _synced < end) {
+            _synced = end;
+        }
+        [self scheduleCompaction];
+    }
+}
+
+// private
+- (void)scheduleCompaction {
+    if (_compactScheduled) {
+        return;
+    }
+    if (_deadBytes < _compactThreshold || _deadBytes * 2 < _offset) {
+        // not worth it
+        return;
+    }
+    _compactScheduled = YES;
+    dispatch_async(_queue, ^{
+        [self compactRecords];
+    });
+}
+
+- (void)compact {
+    dispatch_sync(_queue, ^{
+        [self compactRecords];
+    });
+}
+
+// private, running in the background queue
+- (void)compactRecords {
+    UInt8 *base;
+    size_t end;
+    NSDictionary<NSString *, NSNumber *> *living;
+    // 1. take the living records
+    @synchronized (self) {
+        _compactScheduled = NO;
+        if (!_base) {
+            return;
+        }
+        base = _base;
+        end = _offset;
+        living = [_index copy];
+    }
+    // 2. write them to temporary file, records before the end will not be
+    //    changed and the mapping will not be unmapped before this finished
+    NSArray<NSString *> *keys = [living keysSortedByValueUsingSelector:@selector(compare:)];
+    NSMutableDictionary<NSString *, NSNumber *> *index;
+    index = [[NSMutableDictionary alloc] initWithCapacity:[keys count]];
+    NSMutableData *buffer = [[NSMutableData alloc] initWithBytes:base length:DIM_JOURNAL_HEAD];
+    const JournalRecord *rec;
+    for (NSString *key in keys) {
+        rec = (const JournalRecord *)(base + [[living objectForKey:key] unsignedLongValue]);
+        [index setObject:@([buffer length]) forKey:key];
+        [buffer appendBytes:rec length:record_size(rec)];
+    }
+    NSString *tmp = [_path stringByAppendingString:@".tmp"];
+    int fd = open([tmp fileSystemRepresentation], O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        NSLog(@"[JOURNAL] failed to create %@: %d", tmp, errno);
+        return;
+    }
+    size_t length = [buffer length];
+    if (write(fd, [buffer bytes], length) != (ssize_t)length || fsync(fd) != 0) {
+        NSLog(@"[JOURNAL] failed to write %@: %d", tmp, errno);
+        close(fd);
+        unlink([tmp fileSystemRepresentation]);
+        return;
+    }
+    // 3. swap the mapping, with the records appended while writing
+    @synchronized (self) {
+        if (!_base) {
+            // closed
+            close(fd);
+            unlink([tmp fileSystemRepresentation]);
+            return;
+        }
+        size_t tail = _offset - end;
+        size_t capacity = (length + tail) / DIM_JOURNAL_GROWTH * DIM_JOURNAL_GROWTH + DIM_JOURNAL_GROWTH;
+        void *mapped = MAP_FAILED;
+        if ((tail == 0 || pwrite(fd, _base + end, tail, length) == (ssize_t)tail) &&
+            ftruncate(fd, capacity) == 0) {
+            mapped = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        if (mapped == MAP_FAILED || rename([tmp fileSystemRepresentation], [_path fileSystemRepresentation]) != 0) {
+            NSLog(@"[JOURNAL] failed to replace %@: %d", _path, errno);
+            if (mapped != MAP_FAILED) {
+                munmap(mapped, capacity);
+            }
+            close(fd);
+            unlink([tmp fileSystemRepresentation]);
+            return;
+        }
+        NSLog(@"[JOURNAL] compacted: %lu => %lu bytes", _offset, length + tail);
+        unmap_later(_queue, _base, _capacity);
+        close(_fd);
+        _fd = fd;
+        _base = mapped;
+        _capacity = capacity;
+        _index = index;
+        _deadBytes = 0;
+        _offset = length;
+        _synced = length;
+        while (_offset < length + tail) {
+            rec = (const JournalRecord *)(_base + _offset);
+            [self indexRecord:rec atOffset:_offset];
+            _offset += record_size(rec);
+        }
+        if (tail > 0) {
+            [self scheduleCommit];
+        }
+    }
+}
+
+- (void)close {
+    @synchronized (self) {
+        if (_base) {
+            if (_synced < _offset && msync(_base, _offset, MS_SYNC) != 0) {
+                NSLog(@"[JOURNAL] failed to sync %@: %d", _path, errno);
+            }
+            unmap_later(_queue, _base, _capacity);
+            _base = NULL;
+        }
+        if (_fd >= 0) {
+            close(_fd);
+            _fd = -1;
+        }
+    }
+}
+
+@end
@@ -0,0 +1,94 @@
+// license: https://mit-license.org
+//
+//  DIM-SDK : Decentralized Instant Messaging Software Development Kit
+//
+//                               Written in 2026 by agent <agent@local>
+//
+// =============================================================================
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// =============================================================================
+//
+//  DIMReconnectScheduler.h
+//  DIMClient
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ *  Reconnect Scheduler
+ *  ~~~~~~~~~~~~~~~~~~~
+ *
+ *  Exponential backoff with random jitter, so that clients dropped by the
+ *  same station at the same time will not come back in lockstep:
+ *
+ *      delay = min(maxInterval, baseInterval * 2^attempts)
+ *      delay = delay * (1 - jitter * random[0, 1))
+ *
+ *  Call 'reset' after handshake success.
+ */
+@interface DIMReconnectScheduler : NSObject
+
+// first delay (default 2s)
+@property(nonatomic, assign) NSTimeInterval baseInterval;
+
+// delay cap (default 120s)
+@property(nonatomic, assign) NSTimeInterval maxInterval;
+
+// random part of the delay, 0.0 ~ 1.0 (default 0.5)
+@property(nonatomic, assign) double jitter;
+
+// failed attempts since last reset
+@property(nonatomic, readonly) NSUInteger attempts;
+
+// time for next attempt, 0 means not scheduled
+@property(nonatomic, readonly) NSTimeInterval nextTime;
+
+/**
+ *  Schedule next attempt after connection lost/failed
+ *
+ * @param now - current time
+ * @return delay before next attempt
+ */
+- (NSTimeInterval)scheduleWithTime:(NSTimeInterval)now;
+
+/**
+ *  Check whether it's time to reconnect,
+ *  the schedule will be cleared when it returns YES
+ *
+ * @param now - current time
+ * @return YES to reconnect now
+ */
+- (BOOL)fireWithTime:(NSTimeInterval)now;
+
+/**
+ *  Clear the schedule and the failed attempts
+ */
+- (void)reset;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,100 @@
+// license: https://mit-license.org
+//
+//  DIM-SDK : Decentralized Instant Messaging Software Development Kit
+//
+//                               Written in 2026 by agent <agent@local>
+//
+// =============================================================================
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// =============================================================================
+//
+//  DIMReconnectScheduler.m
+//  DIMClient
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import "DIMReconnectScheduler.h"
+
+// random double in [0, 1)
+static inline double random_unit(void) {
+    return arc4random_uniform(UINT32_MAX) / (double)UINT32_MAX;
+}
+
+@interface DIMReconnectScheduler ()
+
+@property(nonatomic, assign) NSUInteger attempts;
+@property(nonatomic, assign) NSTimeInterval nextTime;
+
+@end
+
+@implementation DIMReconnectScheduler
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _baseInterval = 2;
+        _maxInterval = 120;
+        _jitter = 0.5;
+        _attempts = 0;
+        _nextTime = 0;
+    }
+    return self;
+}
+
+- (NSTimeInterval)scheduleWithTime:(NSTimeInterval)now {
+    @synchronized (self) {
+        if (_nextTime > 0) {
+            // already scheduled
+            return _nextTime - now;
+        }
+        NSTimeInterval delay = _baseInterval;
+        for (NSUInteger i = 0; i < _attempts && delay < _maxInterval; ++i) {
+            delay *= 2;
+        }
+        delay = MIN(delay, _maxInterval);
+        delay *= 1 - _jitter * random_unit();
+        _attempts += 1;
+        _nextTime = now + delay;
+        NSLog(@"[RECONNECT] attempt %lu after %.3f seconds", _attempts, delay);
+        return delay;
+    }
+}
+
+- (BOOL)fireWithTime:(NSTimeInterval)now {
+    @synchronized (self) {
+        if (_nextTime <= 0 || now < _nextTime) {
+            return NO;
+        }
+        _nextTime = 0;
+        return YES;
+    }
+}
+
+- (void)reset {
+    @synchronized (self) {
+        _attempts = 0;
+        _nextTime = 0;
+    }
+}
+
+@end
@@ -0,0 +1,114 @@
+// license: https://mit-license.org
+//
+//  DIM-SDK : Decentralized Instant Messaging Software Development Kit
+//
+//                               Written in 2026 by agent <agent@local>
+//
+// =============================================================================
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// =============================================================================
+//
+//  DIMTokenBucket.h
+//  DIMClient
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ *  Token Bucket
+ *  ~~~~~~~~~~~~
+ *
+ *  Rate limit with two budgets: bytes & messages,
+ *  refilled continuously and capped by the burst sizes.
+ *
+ *  A message can go when there is at least one message token and
+ *  some byte tokens left, its length will be charged even if the byte
+ *  level drops below zero, so a big package will not be blocked forever,
+ *  the following ones just wait longer.
+ */
+@interface DIMTokenBucket : NSObject
+
+// refill rates, 0 means unlimited
+@property(nonatomic, assign) double bytesPerSecond;
+@property(nonatomic, assign) double messagesPerSecond;
+
+// burst sizes (default 1 second of the rates)
+@property(nonatomic, assign) double maxBytes;
+@property(nonatomic, assign) double maxMessages;
+
+// current levels
+@property(nonatomic, readonly) double bytes;
+@property(nonatomic, readonly) double messages;
+
+// times of sending decisions that held back by this bucket
+@property(nonatomic, readonly) NSUInteger throttledCount;
+
+- (instancetype)initWithBytesPerSecond:(double)bps
+                     messagesPerSecond:(double)mps
+NS_DESIGNATED_INITIALIZER;
+
+- (BOOL)isUnlimited;
+
+/**
+ *  Refill tokens and check whether a message can go now
+ *
+ * @param now - current time
+ * @return NO when throttled
+ */
+- (BOOL)isAvailable:(NSTimeInterval)now;
+
+/**
+ *  Count a sending decision held back by this bucket,
+ *  once for each decision however many times it was checked
+ */
+- (void)countThrottled;
+
+/**
+ *  Charge the sent messages
+ *
+ * @param length - package length
+ * @param count  - message count
+ */
+- (void)consumeBytes:(NSUInteger)length messages:(NSUInteger)count;
+
+/**
+ *  Time for tokens to be refilled enough for next message
+ *
+ * @return 0 when available now
+ */
+- (NSTimeInterval)waitInterval;
+
+/**
+ *  Current levels and rates for monitoring
+ *
+ * @return { bytes, messages, bytes_per_second, messages_per_second, throttled }
+ */
+- (NSDictionary<NSString *, NSNumber *> *)metrics;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,146 @@
+// license: https://mit-license.org
+//
+//  DIM-SDK : Decentralized Instant Messaging Software Development Kit
+//
+//                               Written in 2026 by agent <agent@local>
+//
+// =============================================================================
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// =============================================================================
+//
+//  DIMTokenBucket.m
+//  DIMClient
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import "DIMTokenBucket.h"
+
+@interface DIMTokenBucket () {
+    
+    NSTimeInterval _lastTime;  // last refill time
+}
+
+@property(nonatomic, assign) double bytes;
+@property(nonatomic, assign) double messages;
+
+@property(nonatomic, assign) NSUInteger throttledCount;
+
+@end
+
+@implementation DIMTokenBucket
+
+- (instancetype)init {
+    return [self initWithBytesPerSecond:0 messagesPerSecond:0];
+}
+
+/* designated initializer */
+- (instancetype)initWithBytesPerSecond:(double)bps
+                     messagesPerSecond:(double)mps {
+    if (self = [super init]) {
+        _bytesPerSecond = bps;
+        _messagesPerSecond = mps;
+        _maxBytes = bps;
+        _maxMessages = MAX(mps, 1);
+        _bytes = _maxBytes;
+        _messages = _maxMessages;
+        _throttledCount = 0;
+        _lastTime = 0;
+    }
+    return self;
+}
+
+- (BOOL)isUnlimited {
+    return _bytesPerSecond <= 0 && _messagesPerSecond <= 0;
+}
+
+// private
+- (void)refill:(NSTimeInterval)now {
+    NSTimeInterval elapsed = _lastTime > 0 ? now - _lastTime : 0;
+    _lastTime = now;
+    if (elapsed <= 0) {
+        return;
+    }
+    if (_bytesPerSecond > 0) {
+        _bytes = MIN(_maxBytes, _bytes + elapsed * _bytesPerSecond);
+    }
+    if (_messagesPerSecond > 0) {
+        _messages = MIN(_maxMessages, _messages + elapsed * _messagesPerSecond);
+    }
+}
+
+- (BOOL)isAvailable:(NSTimeInterval)now {
+    @synchronized (self) {
+        [self refill:now];
+        if ((_bytesPerSecond <= 0 || _bytes > 0) &&
+            (_messagesPerSecond <= 0 || _messages >= 1)) {
+            return YES;
+        }
+        return NO;
+    }
+}
+
+- (void)countThrottled {
+    @synchronized (self) {
+        ++_throttledCount;
+    }
+}
+
+- (void)consumeBytes:(NSUInteger)length messages:(NSUInteger)count {
+    @synchronized (self) {
+        if (_bytesPerSecond > 0) {
+            _bytes -= length;
+        }
+        if (_messagesPerSecond > 0) {
+            _messages -= count;
+        }
+    }
+}
+
+- (NSTimeInterval)waitInterval {
+    @synchronized (self) {
+        NSTimeInterval wait = 0;
+        if (_bytesPerSecond > 0 && _bytes <= 0) {
+            // need at least one byte
+            wait = MAX(wait, (1 - _bytes) / _bytesPerSecond);
+        }
+        if (_messagesPerSecond > 0 && _messages < 1) {
+            wait = MAX(wait, (1 - _messages) / _messagesPerSecond);
+        }
+        return wait;
+    }
+}
+
+- (NSDictionary<NSString *, NSNumber *> *)metrics {
+    @synchronized (self) {
+        return @{
+            @"bytes": @(_bytes),
+            @"messages": @(_messages),
+            @"bytes_per_second": @(_bytesPerSecond),
+            @"messages_per_second": @(_messagesPerSecond),
+            @"throttled": @(_throttledCount),
+        };
+    }
+}
+
+@end
@@ -44,12 +44,56 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property(nonatomic, readonly) id<DKDReliableMessage> message;
 
+// length of the package data
+@property(nonatomic, readonly) NSUInteger length;
+
+// time when the message was queued
+@property(nonatomic, readonly) NSTimeInterval time;
+
 - (instancetype)initWithReliableMessage:(id<DKDReliableMessage>)rMsg departureShip:(id<STDeparture>)outgo;
 
 @end
 
+/**
+ *  Message Batch
+ *  ~~~~~~~~~~~~~
+ *
+ *  Packages of several messages with the same priority,
+ *  packed in one departure ship to be sent with one write.
+ */
+@interface DIMMessageBatch : NSObject <STDeparture>
+
+@property(nonatomic, readonly) NSArray<DIMMessageWrapper *> *wrappers;
+
+- (instancetype)initWithWrappers:(NSArray<DIMMessageWrapper *> *)wrappers departureShip:(id<STDeparture>)outgo;
+
+@end
+
 @interface DIMMessageQueue : NSObject
 
+// messages & bytes waiting in the queue
+@property(nonatomic, readonly) NSUInteger count;
+@property(nonatomic, readonly) NSUInteger length;
+
+/**
+ *  Watermarks for backpressure:
+ *      when count or length reaches the high watermark, the queue will be
+ *      backpressured until both of them dropped to the low watermarks.
+ *
+ *  defaults: 8192/2048 messages, 32/8 MB
+ */
+@property(nonatomic, assign) NSUInteger highWaterCount;
+@property(nonatomic, assign) NSUInteger lowWaterCount;
+@property(nonatomic, assign) NSUInteger highWaterLength;
+@property(nonatomic, assign) NSUInteger lowWaterLength;
+
+@property(nonatomic, readonly, getter=isBackpressured) BOOL backpressured;
+
+/**
+ *  Index key for checking duplicated messages: "{signature}|{receiver}"
+ */
++ (NSString *)keyForMessage:(id<DKDReliableMessage>)rMsg;
+
 /**
  *  Append message with departure ship
  *
@@ -59,6 +103,16 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (BOOL)appendReliableMessage:(id<DKDReliableMessage>)rMsg departureShip:(id<STDeparture>)ship;
 
+/**
+ *  Append messages with departure ships in one batch
+ *
+ * @param messages - outgoing messages
+ * @param ships    - departure ships
+ * @return count of messages appended
+ */
+- (NSUInteger)appendReliableMessages:(NSArray<id<DKDReliableMessage>> *)messages
+                      departureShips:(NSArray<id<STDeparture>> *)ships;
+
 /**
  *  Get next new message
  *
@@ -66,8 +120,51 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (DIMMessageWrapper *)nextTask;
 
+/**
+ *  Get next message with the same priority for packing in a batch
+ *
+ * @param prior - message priority
+ * @param size  - max length of the package
+ * @return null when no more message fits
+ */
+- (nullable DIMMessageWrapper *)nextTaskWithPriority:(NSInteger)prior maxLength:(NSUInteger)size;
+
+/**
+ *  Get next message with the same priority if it's accepted by the filter,
+ *  the message will stay at the head of the queue when it's not accepted
+ *
+ * @param prior  - message priority
+ * @param filter - check the first message of this priority
+ * @return null when empty or not accepted
+ */
+- (nullable DIMMessageWrapper *)nextTaskWithPriority:(NSInteger)prior
+                                         passingTest:(NS_NOESCAPE BOOL (^)(DIMMessageWrapper *first))filter;
+
+/**
+ *  Get first message of the most important priority accepted by the filter
+ *
+ * @param filter - check the first message of each priority
+ * @return null when no priority accepted
+ */
+- (nullable DIMMessageWrapper *)nextTaskPassingTest:(NS_NOESCAPE BOOL (^)(DIMMessageWrapper *first))filter;
+
+/**
+ *  Put back the messages taken but not sent, in front of the waiting ones
+ *
+ * @param wrappers - taken from this queue, in the original order
+ * @return count of restored messages, the ones appended again are skipped
+ */
+- (NSUInteger)restoreTasks:(NSArray<DIMMessageWrapper *> *)wrappers;
+
 - (void)purge;
 
+/**
+ *  Remove all waiting messages for handing over to another queue
+ *
+ * @return wrappers in priority order
+ */
+- (NSArray<DIMMessageWrapper *> *)removeAllTasks;
+
 @end
 
 @interface DIMMessageQueue (Creation)
@@ -76,4 +173,34 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
+/**
+ *  Multi-Producer Single-Consumer Message Queue
+ *  ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ *  Messenger threads push wrappers into bounded lock-free rings
+ *  (one for each priority class: urgent, normal & slower),
+ *  the gate thread moves them into the waiting fleets when it
+ *  calls 'nextTask', so the producers never wait for the consumer.
+ *
+ *  Duplicated messages are rejected by the producer with striped key sets;
+ *  when a ring is full, the producer drains the rings and appends with
+ *  the lock instead (counted by 'overflowCount'), so no message is lost.
+ */
+@interface DIMConcurrentMessageQueue : DIMMessageQueue
+
+// count of messages appended with the lock because the ring was full
+@property(nonatomic, readonly) NSUInteger overflowCount;
+
+// count of messages moved from rings to the waiting fleets
+@property(nonatomic, readonly) NSUInteger drainedCount;
+
+/**
+ *  Create queue with ring capacity for each priority class
+ *
+ * @param capacity - will be rounded up to a power of 2
+ */
+- (instancetype)initWithCapacity:(NSUInteger)capacity;
+
+@end
+
 NS_ASSUME_NONNULL_END
@@ -35,6 +35,8 @@
 //  Copyright © 2023 DIM Group. All rights reserved.
 //
 
+#import <stdatomic.h>
+
 #import "DIMWrapperQueue.h"
 
 @interface DIMMessageWrapper ()
@@ -52,6 +54,73 @@
     if (self = [super init]) {
         self.message = rMsg;
         self.ship = outgo;
+        _time = OKGetCurrentTimeInterval();
+    }
+    return self;
+}
+
+- (NSUInteger)length {
+    NSUInteger size = 0;
+    for (NSData *fra in [_ship fragments]) {
+        size += [fra length];
+    }
+    return size;
+}
+
+// Override
+- (id<STShipID>)sn {
+    return [_ship sn];
+}
+
+// Override
+- (NSInteger)priority {
+    return [_ship priority];
+}
+
+// Override
+- (NSArray<NSData *> *)fragments {
+    return [_ship fragments];
+}
+
+// Override
+- (BOOL)checkResponseWithinArrivalShip:(id<STArrival>)response {
+    return [_ship checkResponseWithinArrivalShip:response];
+}
+
+// Override
+- (BOOL)isImportant {
+    return [_ship isImportant];
+}
+
+// Override
+- (void)touch:(NSTimeInterval)now {
+    [_ship touch:now];
+}
+
+// Override
+- (STShipStatus)status:(NSTimeInterval)now {
+    return [_ship status:now];
+}
+
+@end
+
+#pragma mark -
+
+@interface DIMMessageBatch ()
+
+@property(nonatomic, strong) NSArray<DIMMessageWrapper *> *wrappers;
+
+@property(nonatomic, strong) id<STDeparture> ship;
+
+@end
+
+@implementation DIMMessageBatch
+
+- (instancetype)initWithWrappers:(NSArray<DIMMessageWrapper *> *)wrappers
+                   departureShip:(id<STDeparture>)outgo {
+    if (self = [super init]) {
+        self.wrappers = wrappers;
+        self.ship = outgo;
     }
     return self;
 }
@@ -97,12 +166,39 @@
 
 typedef OKArrayList<DIMMessageWrapper *> WrapperList;
 
-@interface DIMMessageQueue ()
+// build index key for checking duplicated messages
+//
+// maybe it's a group message split for every members,
+// so we still need to check receiver here.
+static inline NSString *wrapper_key(id<DKDReliableMessage> rMsg) {
+    id signature = [rMsg objectForKey:@"signature"];
+    NSCAssert(signature, @"signature not found: %@", rMsg);
+    id<MKMID> receiver = [rMsg receiver];
+    NSCAssert(receiver, @"receiver not found: %@", rMsg);
+    return [NSString stringWithFormat:@"%@|%@", signature, [receiver string]];
+}
 
+@interface DIMMessageQueue () {
+    
+    _Atomic(NSInteger) _count;
+    _Atomic(NSInteger) _length;
+    atomic_bool _backpressured;
+}
+
+// sorted priorities, smaller is faster
 @property(nonatomic, strong) OKArrayList<NSNumber *> *priorities;
 
 @property(nonatomic, strong) OKHashMap<NSNumber *, WrapperList *> *fleets;
 
+// keys of waiting messages: "{signature}|{receiver}"
+@property(nonatomic, strong) NSMutableSet<NSString *> *index;
+
+// protected
+- (BOOL)appendWrapper:(DIMMessageWrapper *)wrapper;
+
+// protected
+- (void)addCount:(NSInteger)count length:(NSInteger)length;
+
 @end
 
 @implementation DIMMessageQueue
@@ -111,126 +207,265 @@ typedef OKArrayList<DIMMessageWrapper *> WrapperList;
     if (self = [super init]) {
         self.priorities = [OKArrayList array];
         self.fleets = [OKHashMap dictionary];
+        self.index = [[NSMutableSet alloc] init];
+        atomic_init(&_count, 0);
+        atomic_init(&_length, 0);
+        atomic_init(&_backpressured, false);
+        _highWaterCount = 8192;
+        _lowWaterCount = 2048;
+        _highWaterLength = 1 << 25;  // 32 MB
+        _lowWaterLength = 1 << 23;   // 8 MB
     }
     return self;
 }
 
+- (NSUInteger)count {
+    return MAX(atomic_load(&_count), 0);
+}
+
+- (NSUInteger)length {
+    return MAX(atomic_load(&_length), 0);
+}
+
+- (BOOL)isBackpressured {
+    return atomic_load(&_backpressured);
+}
+
+// protected
+- (void)addCount:(NSInteger)count length:(NSInteger)length {
+    NSInteger total = atomic_fetch_add(&_count, count) + count;
+    NSInteger bytes = atomic_fetch_add(&_length, length) + length;
+    if (total >= (NSInteger)_highWaterCount || bytes >= (NSInteger)_highWaterLength) {
+        if (!atomic_exchange(&_backpressured, true)) {
+            NSLog(@"[QUEUE] backpressure on: %ld message(s), %ld byte(s)", total, bytes);
+        }
+    } else if (total <= (NSInteger)_lowWaterCount && bytes <= (NSInteger)_lowWaterLength) {
+        if (atomic_exchange(&_backpressured, false)) {
+            NSLog(@"[QUEUE] backpressure off: %ld message(s), %ld byte(s)", total, bytes);
+        }
+    }
+}
+
++ (NSString *)keyForMessage:(id<DKDReliableMessage>)rMsg {
+    return wrapper_key(rMsg);
+}
+
 - (BOOL)appendReliableMessage:(id<DKDReliableMessage>)rMsg
                 departureShip:(id<STDeparture>)ship {
-    __block BOOL ok = YES;
+    DIMMessageWrapper *wrapper;
+    wrapper = [[DIMMessageWrapper alloc] initWithReliableMessage:rMsg
+                                                   departureShip:ship];
+    if ([self appendWrapper:wrapper]) {
+        [self addCount:1 length:[wrapper length]];
+        return YES;
+    }
+    return NO;
+}
+
+- (NSUInteger)appendReliableMessages:(NSArray<id<DKDReliableMessage>> *)messages
+                      departureShips:(NSArray<id<STDeparture>> *)ships {
+    NSUInteger count = [messages count];
+    NSAssert([ships count] == count, @"ships not match: %lu, %lu", count, [ships count]);
+    NSUInteger success = 0;
+    // hold the lock once for the whole batch
+    @synchronized (self) {
+        for (NSUInteger index = 0; index < count; ++index) {
+            if ([self appendReliableMessage:[messages objectAtIndex:index]
+                              departureShip:[ships objectAtIndex:index]]) {
+                ++success;
+            }
+        }
+    }
+    return success;
+}
+
+// protected
+- (BOOL)appendWrapper:(DIMMessageWrapper *)wrapper {
+    NSString *key = wrapper_key([wrapper message]);
     @synchronized (self) {
-        // 1. choose an array with priority
-        NSInteger priority = [ship priority];
+        // 1. check duplicated
+        if ([_index containsObject:key]) {
+            NSLog(@"[QUEUE] duplicated message: %@", key);
+            return NO;
+        }
+        // 2. choose an array with priority
+        NSInteger priority = [wrapper priority];
         WrapperList *array = [_fleets objectForKey:@(priority)];
         if (!array) {
-            // 1.1. create new array for this priority
+            // 2.1. create new array for this priority
             array = [[OKArrayList alloc] init];
             [_fleets setObject:array forKey:@(priority)];
-            // 1.2. insert the priority in a sorted list
+            // 2.2. insert the priority in a sorted list
             [self insertPriority:priority];
-        } else {
-            // 1.3. check duplicated
-            id signature = [rMsg objectForKey:@"signature"];
-            NSAssert(signature, @"signature not found: %@", rMsg);
-            [array enumerateObjectsUsingBlock:^(DIMMessageWrapper *wrapper, NSUInteger idx, BOOL *stop) {
-                id<DKDReliableMessage> item = [wrapper message];
-                if ([self isDuplicated:item message:rMsg]) {
-                    NSLog(@"[QUEUE] duplicated message: %@", signature);
-                    ok = NO;
-                    *stop = YES;
-                }
-            }];
-        }
-        if (ok) {
-            // 2. append with wrapper
-            DIMMessageWrapper *wrapper;
-            wrapper = [[DIMMessageWrapper alloc] initWithReliableMessage:rMsg
-                                                           departureShip:ship];
-            [array addObject:wrapper];
         }
+        // 3. append the wrapper
+        [array addObject:wrapper];
+        [_index addObject:key];
     }
-    return ok;
-}
-
-// private
-- (BOOL)isDuplicated:(id<DKDReliableMessage>)msg1 message:(id<DKDReliableMessage>)msg2 {
-    id sig1 = [msg1 objectForKey:@"signature"];
-    id sig2 = [msg2 objectForKey:@"signature"];
-    NSAssert(sig1 && sig2, @"signature should not empty here: %@, %@", msg1, msg2);
-    if (![sig1 isEqual:sig2]) {
-        return NO;
-    }
-    // maybe it's a group message split for every members,
-    // so we still need to check receiver here.
-    id<MKMID> to1 = [msg1 receiver];
-    id<MKMID> to2 = [msg2 receiver];
-    NSAssert(to1 && to2, @"receiver should not empty here: %@, %@", msg1, msg2);
-    return [to1 isEqual:to2];
+    return YES;
 }
 
 // private
 - (void)insertPriority:(NSInteger)priority {
-    __block NSInteger index = 0;
-    [_priorities enumerateObjectsUsingBlock:^(NSNumber *prior, NSUInteger idx, BOOL *stop) {
-        NSInteger value = [prior integerValue];
+    // binary search for the first value not smaller than the new value
+    NSUInteger low = 0, high = [_priorities count], mid;
+    NSInteger value;
+    while (low < high) {
+        mid = (low + high) >> 1;
+        value = [[_priorities objectAtIndex:mid] integerValue];
         if (value == priority) {
             // duplicated
-            index = -1;
-            *stop = YES;
-        } else if (value > priority) {
-            // got it
-            index = idx;
-            *stop = YES;
-        }
-        // current value is smaller than the new value,
-        // keep going
-    }];
-    if (index < 0) {
-        return;
+            return;
+        } else if (value < priority) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
     }
     // insert new value before the bigger one
-    [_priorities insertObject:@(priority) atIndex:index];
+    [_priorities insertObject:@(priority) atIndex:low];
 }
 
 - (DIMMessageWrapper *)nextTask {
-    __block DIMMessageWrapper *target = nil;
+    DIMMessageWrapper *target = nil;
     @synchronized (self) {
-        [_priorities enumerateObjectsUsingBlock:^(NSNumber *prior, NSUInteger idx, BOOL *stop) {
+        WrapperList *array;
+        for (NSNumber *prior in _priorities) {
             // get first task
-            WrapperList *array = [_fleets objectForKey:prior];
+            array = [_fleets objectForKey:prior];
             if ([array count] > 0) {
                 target = [array firstObject];
                 [array removeObjectAtIndex:0];
-                *stop = YES;
+                break;
             }
-        }];
+        }
+        if (target) {
+            // the message is leaving, so the same one can be appended again
+            [_index removeObject:wrapper_key([target message])];
+        }
+    }
+    if (target) {
+        [self addCount:-1 length:-(NSInteger)[target length]];
     }
     return target;
 }
 
-- (void)purge {
-    // FIXME: runtime exception
-    //        -[__NSArrayM removeObjectsInRange:]: range {1, 1} extends beyond bounds [0 .. 0]
-    //        -[__NSCFString characterAtIndex:].cold.1 + 0
+- (DIMMessageWrapper *)nextTaskWithPriority:(NSInteger)prior maxLength:(NSUInteger)size {
+    return [self nextTaskWithPriority:prior passingTest:^BOOL(DIMMessageWrapper *first) {
+        // too big for this batch?
+        return [first length] <= size;
+    }];
+}
+
+- (DIMMessageWrapper *)nextTaskWithPriority:(NSInteger)prior
+                                passingTest:(NS_NOESCAPE BOOL (^)(DIMMessageWrapper *))filter {
+    DIMMessageWrapper *target = nil;
+    @synchronized (self) {
+        WrapperList *array = [_fleets objectForKey:@(prior)];
+        target = [array firstObject];
+        if (!target || !filter(target)) {
+            // empty, or not accepted
+            return nil;
+        }
+        [array removeObjectAtIndex:0];
+        [_index removeObject:wrapper_key([target message])];
+    }
+    [self addCount:-1 length:-(NSInteger)[target length]];
+    return target;
+}
+
+- (DIMMessageWrapper *)nextTaskPassingTest:(NS_NOESCAPE BOOL (^)(DIMMessageWrapper *))filter {
+    DIMMessageWrapper *target = nil;
     @synchronized (self) {
-        OKArrayList<NSNumber *> *emptyPositions = [[OKArrayList alloc] init];
-        [_priorities enumerateObjectsWithOptions:NSEnumerationConcurrent
-                                      usingBlock:^(NSNumber *prior, NSUInteger idx, BOOL *stop) {
-            WrapperList *array = [_fleets objectForKey:prior];
+        WrapperList *array;
+        DIMMessageWrapper *first;
+        for (NSNumber *prior in _priorities) {
+            array = [_fleets objectForKey:prior];
+            first = [array firstObject];
+            if (first && filter(first)) {
+                target = first;
+                [array removeObjectAtIndex:0];
+                break;
+            }
+        }
+        if (target) {
+            [_index removeObject:wrapper_key([target message])];
+        }
+    }
+    if (target) {
+        [self addCount:-1 length:-(NSInteger)[target length]];
+    }
+    return target;
+}
+
+- (NSUInteger)restoreTasks:(NSArray<DIMMessageWrapper *> *)wrappers {
+    NSUInteger count = 0;
+    NSInteger length = 0;
+    @synchronized (self) {
+        NSString *key;
+        NSInteger priority;
+        WrapperList *array;
+        // insert from the last one, so the order is kept
+        for (DIMMessageWrapper *item in [wrappers reverseObjectEnumerator]) {
+            key = wrapper_key([item message]);
+            if ([_index containsObject:key]) {
+                // appended again after taken
+                continue;
+            }
+            priority = [item priority];
+            array = [_fleets objectForKey:@(priority)];
             if (!array) {
-                // this priority is empty
-                [emptyPositions addObject:@(idx)];
-            } else if ([array count] == 0) {
+                array = [[OKArrayList alloc] init];
+                [_fleets setObject:array forKey:@(priority)];
+                [self insertPriority:priority];
+            }
+            [array insertObject:item atIndex:0];
+            [_index addObject:key];
+            length += [item length];
+            ++count;
+        }
+    }
+    if (count > 0) {
+        [self addCount:count length:length];
+    }
+    return count;
+}
+
+- (void)purge {
+    @synchronized (self) {
+        NSNumber *prior;
+        WrapperList *array;
+        NSUInteger pos = [_priorities count];
+        while (pos > 0) {
+            prior = [_priorities objectAtIndex:--pos];
+            array = [_fleets objectForKey:prior];
+            if ([array count] == 0) {
                 // this priority is empty
                 [_fleets removeObjectForKey:prior];
-                [emptyPositions addObject:@(idx)];
+                [_priorities removeObjectAtIndex:pos];
+            }
+        }
+    }
+}
+
+- (NSArray<DIMMessageWrapper *> *)removeAllTasks {
+    NSMutableArray<DIMMessageWrapper *> *wrappers = [[NSMutableArray alloc] init];
+    NSInteger length = 0;
+    @synchronized (self) {
+        WrapperList *array;
+        for (NSNumber *prior in _priorities) {
+            array = [_fleets objectForKey:prior];
+            for (DIMMessageWrapper *item in array) {
+                length += [item length];
             }
-        }];
-        [emptyPositions enumerateObjectsWithOptions:NSEnumerationReverse
-                                  usingBlock:^(NSNumber *pos, NSUInteger idx, BOOL *stop) {
-            [_priorities removeObjectAtIndex:[pos integerValue]];
-        }];
+            [wrappers addObjectsFromArray:array];
+        }
+        [_priorities removeAllObjects];
+        [_fleets removeAllObjects];
+        [_index removeAllObjects];
     }
+    [self addCount:-(NSInteger)[wrappers count] length:-length];
+    return wrappers;
 }
 
 @end
@@ -238,7 +473,295 @@ typedef OKArrayList<DIMMessageWrapper *> WrapperList;
 @implementation DIMMessageQueue (Creation)
 
 + (instancetype)queue {
-    return [[DIMMessageQueue alloc] init];
+    return [[self alloc] init];
+}
+
+@end
+
+#pragma mark - Bounded MPSC Ring
+
+typedef struct {
+    _Atomic(NSUInteger) sequence;
+    void *item;  // retained object
+} RingCell;
+
+typedef struct {
+    NSUInteger mask;
+    RingCell *cells;
+    _Atomic(NSUInteger) head;  // next position to write (producers)
+    NSUInteger tail;           // next position to read (consumer only)
+} WrapperRing;
+
+static inline void ring_init(WrapperRing *ring, NSUInteger capacity) {
+    NSUInteger size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    ring->mask = size - 1;
+    ring->cells = calloc(size, sizeof(RingCell));
+    for (NSUInteger i = 0; i < size; ++i) {
+        atomic_init(&ring->cells[i].sequence, i);
+    }
+    atomic_init(&ring->head, 0);
+    ring->tail = 0;
+}
+
+// called by any thread
+static inline bool ring_push(WrapperRing *ring, void *item) {
+    NSUInteger pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    RingCell *cell;
+    NSUInteger seq;
+    NSInteger diff;
+    for (;;) {
+        cell = &ring->cells[pos & ring->mask];
+        seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        diff = (NSInteger)seq - (NSInteger)pos;
+        if (diff == 0) {
+            // cell is free, try to claim it
+            if (atomic_compare_exchange_weak_explicit(&ring->head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+            // 'pos' was reloaded by the failed CAS
+        } else if (diff < 0) {
+            // ring is full
+            return false;
+        } else {
+            // another producer moved forward
+            pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        }
+    }
+    cell->item = item;
+    atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+    return true;
+}
+
+// called by the consumer thread only
+static inline void *ring_pop(WrapperRing *ring) {
+    NSUInteger pos = ring->tail;
+    RingCell *cell = &ring->cells[pos & ring->mask];
+    NSUInteger seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    if (seq != pos + 1) {
+        // empty, or the producer has not finished writing yet
+        return NULL;
+    }
+    void *item = cell->item;
+    cell->item = NULL;
+    ring->tail = pos + 1;
+    atomic_store_explicit(&cell->sequence, pos + ring->mask + 1, memory_order_release);
+    return item;
+}
+
+#pragma mark -
+
+#define DIM_RING_CLASS_COUNT 3  // urgent, normal, slower
+#define DIM_KEY_STRIPES       16
+
+static inline NSUInteger ring_class(NSInteger priority) {
+    if (priority < STDeparturePriorityNormal) {
+        return 0;
+    } else if (priority == STDeparturePriorityNormal) {
+        return 1;
+    } else {
+        return 2;
+    }
+}
+
+@interface DIMConcurrentMessageQueue () {
+    
+    WrapperRing _rings[DIM_RING_CLASS_COUNT];
+    
+    // keys of messages in the rings or the waiting fleets,
+    // striped so the producers seldom wait for each other
+    NSArray<NSMutableSet<NSString *> *> *_keys;
+    
+    _Atomic(NSUInteger) _overflowCount;
+    NSUInteger _drainedCount;
+}
+
+@end
+
+@implementation DIMConcurrentMessageQueue
+
+- (instancetype)init {
+    return [self initWithCapacity:1024];
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity {
+    if (self = [super init]) {
+        for (NSUInteger i = 0; i < DIM_RING_CLASS_COUNT; ++i) {
+            ring_init(&_rings[i], capacity);
+        }
+        NSMutableArray *stripes = [[NSMutableArray alloc] initWithCapacity:DIM_KEY_STRIPES];
+        for (NSUInteger i = 0; i < DIM_KEY_STRIPES; ++i) {
+            [stripes addObject:[[NSMutableSet alloc] init]];
+        }
+        _keys = stripes;
+        atomic_init(&_overflowCount, 0);
+        _drainedCount = 0;
+    }
+    return self;
+}
+
+- (void)dealloc {
+    void *item;
+    for (NSUInteger i = 0; i < DIM_RING_CLASS_COUNT; ++i) {
+        while ((item = ring_pop(&_rings[i]))) {
+            CFBridgingRelease(item);
+        }
+        free(_rings[i].cells);
+    }
+}
+
+- (NSUInteger)overflowCount {
+    return atomic_load_explicit(&_overflowCount, memory_order_relaxed);
+}
+
+- (NSUInteger)drainedCount {
+    @synchronized (self) {
+        return _drainedCount;
+    }
+}
+
+// private
+- (BOOL)insertKey:(NSString *)key {
+    NSMutableSet *stripe = [_keys objectAtIndex:([key hash] % DIM_KEY_STRIPES)];
+    @synchronized (stripe) {
+        if ([stripe containsObject:key]) {
+            return NO;
+        }
+        [stripe addObject:key];
+        return YES;
+    }
+}
+
+// private
+- (void)removeKey:(NSString *)key {
+    NSMutableSet *stripe = [_keys objectAtIndex:([key hash] % DIM_KEY_STRIPES)];
+    @synchronized (stripe) {
+        [stripe removeObject:key];
+    }
+}
+
+// Override
+- (BOOL)appendReliableMessage:(id<DKDReliableMessage>)rMsg
+                departureShip:(id<STDeparture>)ship {
+    NSString *key = [DIMMessageQueue keyForMessage:rMsg];
+    if (![self insertKey:key]) {
+        NSLog(@"[QUEUE] duplicated message: %@", key);
+        return NO;
+    }
+    DIMMessageWrapper *wrapper;
+    wrapper = [[DIMMessageWrapper alloc] initWithReliableMessage:rMsg
+                                                   departureShip:ship];
+    WrapperRing *ring = &_rings[ring_class([ship priority])];
+    void *item = (void *)CFBridgingRetain(wrapper);
+    if (ring_push(ring, item)) {
+        [self addCount:1 length:[wrapper length]];
+        return YES;
+    }
+    CFBridgingRelease(item);
+    // ring is full, move the earlier ones out first to keep the order,
+    // then append this one with the lock
+    atomic_fetch_add_explicit(&_overflowCount, 1, memory_order_relaxed);
+    BOOL ok;
+    @synchronized (self) {
+        [self drain];
+        ok = [self appendWrapper:wrapper];
+    }
+    if (ok) {
+        [self addCount:1 length:[wrapper length]];
+    } else {
+        [self removeKey:key];
+    }
+    return ok;
+}
+
+// Override
+- (NSUInteger)appendReliableMessages:(NSArray<id<DKDReliableMessage>> *)messages
+                      departureShips:(NSArray<id<STDeparture>> *)ships {
+    NSUInteger count = [messages count];
+    NSAssert([ships count] == count, @"ships not match: %lu, %lu", count, [ships count]);
+    NSUInteger success = 0;
+    // no lock needed for pushing into the rings
+    for (NSUInteger index = 0; index < count; ++index) {
+        if ([self appendReliableMessage:[messages objectAtIndex:index]
+                          departureShip:[ships objectAtIndex:index]]) {
+            ++success;
+        }
+    }
+    return success;
+}
+
+// private
+- (void)drain {
+    DIMMessageWrapper *wrapper;
+    void *item;
+    // the lock makes sure only one thread pops the rings at a time
+    @synchronized (self) {
+        for (NSUInteger i = 0; i < DIM_RING_CLASS_COUNT; ++i) {
+            while ((item = ring_pop(&_rings[i]))) {
+                wrapper = CFBridgingRelease(item);
+                if (![self appendWrapper:wrapper]) {
+                    // should not happen, duplicates were rejected by the keys
+                    [self addCount:-1 length:-(NSInteger)[wrapper length]];
+                }
+                ++_drainedCount;
+            }
+        }
+    }
+}
+
+// private
+- (DIMMessageWrapper *)leave:(DIMMessageWrapper *)wrapper {
+    if (wrapper) {
+        // the message is leaving, so the same one can be appended again
+        [self removeKey:[DIMMessageQueue keyForMessage:[wrapper message]]];
+    }
+    return wrapper;
+}
+
+// Override
+- (DIMMessageWrapper *)nextTask {
+    [self drain];
+    return [self leave:[super nextTask]];
+}
+
+// Override
+- (DIMMessageWrapper *)nextTaskWithPriority:(NSInteger)prior
+                                passingTest:(NS_NOESCAPE BOOL (^)(DIMMessageWrapper *))filter {
+    [self drain];
+    return [self leave:[super nextTaskWithPriority:prior passingTest:filter]];
+}
+
+// Override
+- (DIMMessageWrapper *)nextTaskPassingTest:(NS_NOESCAPE BOOL (^)(DIMMessageWrapper *))filter {
+    [self drain];
+    return [self leave:[super nextTaskPassingTest:filter]];
+}
+
+// Override
+- (NSUInteger)restoreTasks:(NSArray<DIMMessageWrapper *> *)wrappers {
+    NSMutableArray<DIMMessageWrapper *> *taken;
+    taken = [[NSMutableArray alloc] initWithCapacity:[wrappers count]];
+    for (DIMMessageWrapper *item in wrappers) {
+        if ([self insertKey:[DIMMessageQueue keyForMessage:[item message]]]) {
+            [taken addObject:item];
+        }
+    }
+    // the rings only hold the newer ones, so the taken ones go to the front
+    return [super restoreTasks:taken];
+}
+
+// Override
+- (NSArray<DIMMessageWrapper *> *)removeAllTasks {
+    [self drain];
+    NSArray<DIMMessageWrapper *> *wrappers = [super removeAllTasks];
+    for (DIMMessageWrapper *item in wrappers) {
+        [self leave:item];
+    }
+    return wrappers;
 }
 
 @end
@@ -36,6 +36,7 @@
 //
 
 #import <DIMClient/STStreamHub.h>
+#import <DIMClient/STStreamFramer.h>
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -43,6 +44,10 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property(nonatomic, strong) Hub hub;
 
+// max bytes cached for each connection before a docker created (default 64 KB),
+// the default docker will be used when exceeded
+@property(nonatomic, assign) NSUInteger maxAdvancePartyLength;
+
 @end
 
 @interface STBaseGate (Docker)
@@ -51,6 +56,22 @@ NS_ASSUME_NONNULL_BEGIN
                         remoteAddress:(id<NIOSocketAddress>)remote
                          localAddress:(nullable id<NIOSocketAddress>)local;
 
+/**
+ *  Check the advance party to decide the stream format
+ *
+ *  All formats are read by the same stream docker (its framer checks
+ *  each frame), the format only decides how the docker answers:
+ *  in binary frames for STStreamFormatBinary, or in JSON lines.
+ *
+ * @param advanceParty - data received before docker created;
+ *                       nil means we are going to send first (client),
+ *                       JSON lines will be used until the handshake
+ *                       turns on binary framing
+ * @return STStreamFormatUnknown when need more bytes
+ */
+// protected
+- (STStreamFormat)formatOfAdvanceParty:(nullable NSArray<NSData *> *)advanceParty;
+
 @end
 
 @interface STCommonGate : STBaseGate<STStreamHub *>
@@ -68,10 +89,29 @@ NS_ASSUME_NONNULL_BEGIN
        remoteAddress:(id<NIOSocketAddress>)remote
         localAddress:(nullable id<NIOSocketAddress>)local;
 
+/**
+ *  Get smoothed round trip time of the connection
+ *
+ * @return negative value when not measured yet
+ */
+- (NSTimeInterval)roundTripTimeForRemoteAddress:(id<NIOSocketAddress>)remote
+                                   localAddress:(nullable id<NIOSocketAddress>)local;
+
+/**
+ *  Close the docker and its channel, so that a new connection
+ *  will be created for the remote address next time
+ */
+- (void)closeDockerForRemoteAddress:(id<NIOSocketAddress>)remote
+                       localAddress:(nullable id<NIOSocketAddress>)local;
+
 @end
 
 /**
  *  TCP Client Gate
+ *
+ *  Creates stream dockers only, answering in binary frames when the
+ *  remote sent them first; Mars, JSON & text streams are all answered
+ *  in JSON lines.
  */
 @interface STTCPClientGate : STCommonGate
 
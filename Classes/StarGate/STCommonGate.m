@@ -39,8 +39,24 @@
 
 #import "STCommonGate.h"
 
+@interface STBaseGate () {
+    
+    // connection => received data before docker created
+    NSMapTable<id<STConnection>, NSMutableArray<NSData *> *> *_advanceParties;
+}
+
+@end
+
 @implementation STBaseGate
 
+- (instancetype)initWithDockerDelegate:(id<STDockerDelegate>)delegate {
+    if (self = [super initWithDockerDelegate:delegate]) {
+        _advanceParties = [NSMapTable weakToStrongObjectsMapTable];
+        _maxAdvancePartyLength = 1 << 16;  // 64 KB
+    }
+    return self;
+}
+
 // Override
 - (id<STDocker>)dockerWithRemoteAddress:(id<NIOSocketAddress>)remote
                            localAddress:(id<NIOSocketAddress>)local {
@@ -74,17 +90,25 @@
 // Override
 - (NSArray<NSData *> *)cacheAdvanceParty:(NSData *)data
                            forConnection:(id<STConnection>)conn {
-    // TODO: cache the advance party before decide which docker to use
-    if ([data length] > 0) {
-        return @[data];
-    } else {
-        return nil;
+    // cache the advance party before decide which docker to use
+    @synchronized (_advanceParties) {
+        NSMutableArray<NSData *> *array = [_advanceParties objectForKey:conn];
+        if (!array) {
+            array = [[NSMutableArray alloc] init];
+            [_advanceParties setObject:array forKey:conn];
+        }
+        if ([data length] > 0) {
+            [array addObject:data];
+        }
+        return [array copy];
     }
 }
 
 // Override
 - (void)clearAdvancePartyForConnection:(id<STConnection>)conn {
-    // TODO: remove advance party for this connection
+    @synchronized (_advanceParties) {
+        [_advanceParties removeObjectForKey:conn];
+    }
 }
 
 @end
@@ -109,6 +133,27 @@
     return docker;
 }
 
+- (STStreamFormat)formatOfAdvanceParty:(nullable NSArray<NSData *> *)advanceParty {
+    if (!advanceParty) {
+        // we are going to send first, use the default format
+        return STStreamFormatJSON;
+    }
+    STStreamFormat format = [STStreamFramer formatOfData:advanceParty];
+    if (format != STStreamFormatUnknown) {
+        return format;
+    }
+    NSUInteger length = 0;
+    for (NSData *item in advanceParty) {
+        length += [item length];
+    }
+    if (length < _maxAdvancePartyLength) {
+        // wait for more bytes
+        return STStreamFormatUnknown;
+    }
+    NSLog(@"[GATE] advance party too long: %lu, use default format", length);
+    return STStreamFormatJSON;
+}
+
 @end
 
 #pragma mark -
@@ -159,6 +204,32 @@
     return [docker sendData:payload];
 }
 
+- (NSTimeInterval)roundTripTimeForRemoteAddress:(id<NIOSocketAddress>)remote
+                                   localAddress:(nullable id<NIOSocketAddress>)local {
+    id<STDocker> docker = [self dockerWithRemoteAddress:remote localAddress:local];
+    if ([docker isKindOfClass:[STPlainDocker class]]) {
+        return [(STPlainDocker *)docker roundTripTime];
+    }
+    return -1;
+}
+
+- (void)closeDockerForRemoteAddress:(id<NIOSocketAddress>)remote
+                       localAddress:(nullable id<NIOSocketAddress>)local {
+    // 1. remove docker
+    id<STDocker> docker = [self dockerWithRemoteAddress:remote localAddress:local];
+    if (docker) {
+        [self removeDocker:docker remoteAddress:remote localAddress:local];
+        [docker close];
+    }
+    // 2. remove channel
+    STStreamHub *hub = [self hub];
+    id<STChannel> channel = [hub channelForRemoteAddress:remote localAddress:local];
+    if (channel) {
+        [hub removeChannel:channel remoteAddress:remote localAddress:local];
+        [channel close];
+    }
+}
+
 @end
 
 @implementation STTCPClientGate
@@ -166,7 +237,26 @@
 // Override
 - (id<STDocker>)createDockerWithConnection:(id<STConnection>)conn
                               advanceParty:(NSArray<NSData *> *)data {
-    STStreamDocker *docker = [[STStreamDocker alloc] initWithConnection:conn];
+    STStreamDocker *docker;
+    STStreamFormat format = [self formatOfAdvanceParty:data];
+    switch (format) {
+        case STStreamFormatUnknown:
+            // not enough bytes to decide which docker to use,
+            // keep the advance party and wait for next time
+            return nil;
+            
+        case STStreamFormatBinary:
+            // remote is talking in binary frames, answer in the same way
+            docker = [[STStreamDocker alloc] initWithConnection:conn];
+            [docker setBinaryFraming:YES];
+            break;
+            
+        default:
+            // JSON lines, Mars SN head or text: the framer reads them all,
+            // and the docker answers in JSON lines
+            docker = [[STStreamDocker alloc] initWithConnection:conn];
+            break;
+    }
     [docker setDelegate:self.delegate];
     return docker;
 }
@@ -0,0 +1,92 @@
+// license: https://mit-license.org
+//
+//  Star Gate: Network Connection Module
+//
+//                               Written in 2026 by agent <agent@local>
+//
+// =============================================================================
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// =============================================================================
+//
+//  STSocketOptions.h
+//  DIMClient
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ *  Socket Options
+ *  ~~~~~~~~~~~~~~
+ *
+ *  Tuning profile for TCP connections, zero means using the system default.
+ *
+ *  Dictionary format: {
+ *      sndbuf        : 262144,  // SO_SNDBUF
+ *      rcvbuf        : 262144,  // SO_RCVBUF
+ *      nodelay       : true,    // TCP_NODELAY
+ *      keepalive     : true,    // SO_KEEPALIVE
+ *      keepidle      : 60,      // seconds before first probe
+ *      keepintvl     : 10,      // seconds between probes
+ *      keepcnt       : 3,       // probes before dropping
+ *      user_timeout  : 30       // seconds for unacknowledged data (Linux only)
+ *  }
+ */
+@interface STSocketOptions : NSObject <NSCopying>
+
+@property(nonatomic, assign) NSInteger sendBufferSize;
+@property(nonatomic, assign) NSInteger receiveBufferSize;
+
+@property(nonatomic, assign) BOOL noDelay;
+
+@property(nonatomic, assign) BOOL keepAlive;
+@property(nonatomic, assign) NSInteger keepAliveIdle;
+@property(nonatomic, assign) NSInteger keepAliveInterval;
+@property(nonatomic, assign) NSInteger keepAliveCount;
+
+@property(nonatomic, assign) NSInteger userTimeout;
+
+- (instancetype)initWithDictionary:(NSDictionary *)dict;
+
+- (NSDictionary *)dictionary;
+
+/**
+ *  Set options to the socket
+ *
+ * @param fd - native socket handle
+ * @return values actually applied (read back from the socket); nil on error
+ */
+- (nullable STSocketOptions *)applyToSocket:(int)fd;
+
+/**
+ *  Default profile: larger buffers for catching up after long offline,
+ *  no delay for small packages, and keepalive for detecting dead links
+ */
++ (instancetype)defaultOptions;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,206 @@
+// license: https://mit-license.org
+//
+//  Star Gate: Network Connection Module
+//
+//                               Written in 2026 by agent <agent@local>
+//
+// =============================================================================
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// =============================================================================
+//
+//  STSocketOptions.m
+//  DIMClient
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import <sys/socket.h>
+#import <netinet/in.h>
+#import <netinet/tcp.h>
+
+#import <MingKeMing/MingKeMing.h>
+
+#import "STSocketOptions.h"
+
+static inline int set_option(int fd, int level, int name, NSInteger value) {
+    int opt = (int)value;
+    return setsockopt(fd, level, name, &opt, sizeof(opt));
+}
+
+static inline NSInteger get_option(int fd, int level, int name) {
+    int opt = 0;
+    socklen_t len = sizeof(opt);
+    if (getsockopt(fd, level, name, &opt, &len) != 0) {
+        return -1;
+    }
+    return opt;
+}
+
+#if defined(TCP_KEEPIDLE)
+#define ST_TCP_KEEPIDLE TCP_KEEPIDLE
+#elif defined(TCP_KEEPALIVE)
+#define ST_TCP_KEEPIDLE TCP_KEEPALIVE  // Darwin
+#endif
+
+@implementation STSocketOptions
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _sendBufferSize = 0;
+        _receiveBufferSize = 0;
+        _noDelay = NO;
+        _keepAlive = NO;
+        _keepAliveIdle = 0;
+        _keepAliveInterval = 0;
+        _keepAliveCount = 0;
+        _userTimeout = 0;
+    }
+    return self;
+}
+
+- (instancetype)initWithDictionary:(NSDictionary *)dict {
+    if (self = [self init]) {
+        _sendBufferSize = MKConvertInteger([dict objectForKey:@"sndbuf"], 0);
+        _receiveBufferSize = MKConvertInteger([dict objectForKey:@"rcvbuf"], 0);
+        _noDelay = MKConvertBool([dict objectForKey:@"nodelay"], NO);
+        _keepAlive = MKConvertBool([dict objectForKey:@"keepalive"], NO);
+        _keepAliveIdle = MKConvertInteger([dict objectForKey:@"keepidle"], 0);
+        _keepAliveInterval = MKConvertInteger([dict objectForKey:@"keepintvl"], 0);
+        _keepAliveCount = MKConvertInteger([dict objectForKey:@"keepcnt"], 0);
+        _userTimeout = MKConvertInteger([dict objectForKey:@"user_timeout"], 0);
+    }
+    return self;
+}
+
+- (id)copyWithZone:(nullable NSZone *)zone {
+    STSocketOptions *options = [[[self class] allocWithZone:zone] init];
+    if (options) {
+        options.sendBufferSize = _sendBufferSize;
+        options.receiveBufferSize = _receiveBufferSize;
+        options.noDelay = _noDelay;
+        options.keepAlive = _keepAlive;
+        options.keepAliveIdle = _keepAliveIdle;
+        options.keepAliveInterval = _keepAliveInterval;
+        options.keepAliveCount = _keepAliveCount;
+        options.userTimeout = _userTimeout;
+    }
+    return options;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@ %@ />", [self class], [self dictionary]];
+}
+
+- (NSDictionary *)dictionary {
+    return @{
+        @"sndbuf": @(_sendBufferSize),
+        @"rcvbuf": @(_receiveBufferSize),
+        @"nodelay": @(_noDelay),
+        @"keepalive": @(_keepAlive),
+        @"keepidle": @(_keepAliveIdle),
+        @"keepintvl": @(_keepAliveInterval),
+        @"keepcnt": @(_keepAliveCount),
+        @"user_timeout": @(_userTimeout),
+    };
+}
+
+- (nullable STSocketOptions *)applyToSocket:(int)fd {
+    if (fd < 0) {
+        return nil;
+    }
+    // 1. buffer sizes
+    if (_sendBufferSize > 0 && set_option(fd, SOL_SOCKET, SO_SNDBUF, _sendBufferSize) != 0) {
+        NSLog(@"[SOCKET] failed to set send buffer: %ld, errno=%d", _sendBufferSize, errno);
+    }
+    if (_receiveBufferSize > 0 && set_option(fd, SOL_SOCKET, SO_RCVBUF, _receiveBufferSize) != 0) {
+        NSLog(@"[SOCKET] failed to set receive buffer: %ld, errno=%d", _receiveBufferSize, errno);
+    }
+    // 2. Nagle's algorithm
+    if (_noDelay && set_option(fd, IPPROTO_TCP, TCP_NODELAY, 1) != 0) {
+        NSLog(@"[SOCKET] failed to set no delay, errno=%d", errno);
+    }
+    // 3. keepalive
+    if (_keepAlive) {
+        if (set_option(fd, SOL_SOCKET, SO_KEEPALIVE, 1) != 0) {
+            NSLog(@"[SOCKET] failed to set keepalive, errno=%d", errno);
+        }
+#ifdef ST_TCP_KEEPIDLE
+        if (_keepAliveIdle > 0) {
+            set_option(fd, IPPROTO_TCP, ST_TCP_KEEPIDLE, _keepAliveIdle);
+        }
+#endif
+#ifdef TCP_KEEPINTVL
+        if (_keepAliveInterval > 0) {
+            set_option(fd, IPPROTO_TCP, TCP_KEEPINTVL, _keepAliveInterval);
+        }
+#endif
+#ifdef TCP_KEEPCNT
+        if (_keepAliveCount > 0) {
+            set_option(fd, IPPROTO_TCP, TCP_KEEPCNT, _keepAliveCount);
+        }
+#endif
+    }
+    // 4. user timeout (milliseconds)
+#ifdef TCP_USER_TIMEOUT
+    if (_userTimeout > 0) {
+        set_option(fd, IPPROTO_TCP, TCP_USER_TIMEOUT, _userTimeout * 1000);
+    }
+#endif
+    //
+    //  read back the values actually applied,
+    //  NOTICE: the kernel may double or clamp the buffer sizes
+    //
+    STSocketOptions *applied = [[STSocketOptions alloc] init];
+    applied.sendBufferSize = get_option(fd, SOL_SOCKET, SO_SNDBUF);
+    applied.receiveBufferSize = get_option(fd, SOL_SOCKET, SO_RCVBUF);
+    applied.noDelay = get_option(fd, IPPROTO_TCP, TCP_NODELAY) > 0;
+    applied.keepAlive = get_option(fd, SOL_SOCKET, SO_KEEPALIVE) > 0;
+#ifdef ST_TCP_KEEPIDLE
+    applied.keepAliveIdle = get_option(fd, IPPROTO_TCP, ST_TCP_KEEPIDLE);
+#endif
+#ifdef TCP_KEEPINTVL
+    applied.keepAliveInterval = get_option(fd, IPPROTO_TCP, TCP_KEEPINTVL);
+#endif
+#ifdef TCP_KEEPCNT
+    applied.keepAliveCount = get_option(fd, IPPROTO_TCP, TCP_KEEPCNT);
+#endif
+#ifdef TCP_USER_TIMEOUT
+    applied.userTimeout = get_option(fd, IPPROTO_TCP, TCP_USER_TIMEOUT) / 1000;
+#endif
+    return applied;
+}
+
++ (instancetype)defaultOptions {
+    STSocketOptions *options = [[self alloc] init];
+    options.sendBufferSize = 1 << 18;     // 256 KB
+    options.receiveBufferSize = 1 << 18;  // 256 KB
+    options.noDelay = YES;
+    options.keepAlive = YES;
+    options.keepAliveIdle = 60;
+    options.keepAliveInterval = 10;
+    options.keepAliveCount = 3;
+    options.userTimeout = 30;
+    return options;
+}
+
+@end
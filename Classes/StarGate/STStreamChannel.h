@@ -37,10 +37,31 @@
 
 #import <StarTrek/StarTrek.h>
 
+#import <DIMClient/STSocketOptions.h>
+
 NS_ASSUME_NONNULL_BEGIN
 
 @interface STStreamChannel : STChannel<NIOSocketChannel *>
 
+/**
+ *  Native handle of the socket
+ *
+ *  It's kept by the hub when the channel created, because the NIO socket
+ *  channel doesn't expose its handle; -1 when not available
+ */
+@property(nonatomic, assign) int socketDescriptor;
+
+// socket options actually applied
+@property(nonatomic, strong, nullable) STSocketOptions *socketOptions;
+
+/**
+ *  Apply tuning profile to the socket
+ *
+ * @param options - socket options
+ * @return values actually applied; nil when the socket handle not available
+ */
+- (nullable STSocketOptions *)applySocketOptions:(STSocketOptions *)options;
+
 @end
 
 NS_ASSUME_NONNULL_END
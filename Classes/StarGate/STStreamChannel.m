@@ -73,6 +73,28 @@
 
 @implementation STStreamChannel
 
+// Override
+- (instancetype)initWithSocket:(NIOSocketChannel *)sock
+                 remoteAddress:(id<NIOSocketAddress>)remote
+                  localAddress:(nullable id<NIOSocketAddress>)local {
+    if (self = [super initWithSocket:sock remoteAddress:remote localAddress:local]) {
+        _socketDescriptor = -1;
+        _socketOptions = nil;
+    }
+    return self;
+}
+
+- (nullable STSocketOptions *)applySocketOptions:(STSocketOptions *)options {
+    if (_socketDescriptor < 0) {
+        NSLog(@"[SOCKET] socket handle not available: %@", self.remoteAddress);
+        return nil;
+    }
+    STSocketOptions *applied = [options applyToSocket:_socketDescriptor];
+    NSLog(@"[SOCKET] options applied: %@, %@", applied, self.remoteAddress);
+    self.socketOptions = applied;
+    return applied;
+}
+
 // Override
 - (id<STSocketReader>)createReader {
     return [[__StreamChannelReader alloc] initWithChannel:self];
@@ -39,8 +39,28 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+// heartbeat interval will back off from MIN to MAX when traffic is flowing,
+// MAX should be less than the time a silent connection treated as error
+#define STHeartbeatMinInterval 16.0
+#define STHeartbeatMaxInterval 64.0
+
 @interface STPlainDocker : STDocker
 
+// smoothed round trip time of PING/PONG, negative when not measured yet
+@property(nonatomic, readonly) NSTimeInterval roundTripTime;
+
+// mean deviation of the round trip time
+@property(nonatomic, readonly) NSTimeInterval jitter;
+
+// round trip time of the last PONG
+@property(nonatomic, readonly) NSTimeInterval lastRoundTripTime;
+
+// current interval for sending PING
+@property(nonatomic, readonly) NSTimeInterval heartbeatInterval;
+
+@property(nonatomic, readonly) NSUInteger pingCount;
+@property(nonatomic, readonly) NSUInteger pongCount;
+
 // protected
 - (id<STArrival>)createArrivalWithData:(NSData *)pack;
 
@@ -64,6 +84,10 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface STStreamDocker : STPlainDocker <STDeparturePacker>
 
+// pack outgoing data into binary frames instead of JSON lines,
+// incoming frames in both formats are always accepted
+@property(nonatomic, assign, getter=isBinaryFraming) BOOL binaryFraming;
+
 @end
 
 NS_ASSUME_NONNULL_END
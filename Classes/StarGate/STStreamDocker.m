@@ -37,19 +37,59 @@
 
 #import "STStreamArrival.h"
 #import "STStreamDeparture.h"
+#import "STStreamFramer.h"
 
 #import "STStreamDocker.h"
 
-static NSString *PING = @"PING";
-static NSString *PONG = @"PONG";
-static NSString *NOOP = @"NOOP";
+static const unsigned char control_ping[] = "PING";
+static const unsigned char control_pong[] = "PONG";
+static const unsigned char control_noop[] = "NOOP";
 
-static inline NSData *utf8_encode(NSString *string) {
-    return [string dataUsingEncoding:NSUTF8StringEncoding];
+static NSData *ping_data = nil;
+static NSData *pong_data = nil;
+
+static inline NSData *control_data(const unsigned char *word) {
+    return [[NSData alloc] initWithBytesNoCopy:(void *)word
+                                        length:4
+                                  freeWhenDone:NO];
+}
+
+static inline BOOL is_control(NSData *data, const unsigned char *word) {
+    return memcmp([data bytes], word, 4) == 0;
+}
+
+@interface STPlainDocker () {
+    
+    NSTimeInterval _pingTime;      // time of the PING waiting for PONG
+    BOOL _pingRetried;             // PING sent again before PONG received
+    NSTimeInterval _lastPingTime;  // time of the last PING sent
+    NSTimeInterval _lastActive;    // time of the last package received
 }
 
+@end
+
 @implementation STPlainDocker
 
+- (instancetype)initWithConnection:(id<STConnection>)conn {
+    if (self = [super initWithConnection:conn]) {
+        OKSingletonDispatchOnce(^{
+            ping_data = control_data(control_ping);
+            pong_data = control_data(control_pong);
+        });
+        _roundTripTime = -1;
+        _jitter = 0;
+        _lastRoundTripTime = -1;
+        _heartbeatInterval = STHeartbeatMinInterval;
+        _pingCount = 0;
+        _pongCount = 0;
+        _pingTime = 0;
+        _pingRetried = NO;
+        _lastPingTime = 0;
+        _lastActive = 0;
+    }
+    return self;
+}
+
 - (id<STArrival>)createArrivalWithData:(NSData *)pack {
     return [[STPlainArrival alloc] initWithData:pack];
 }
@@ -70,14 +110,17 @@ static inline NSData *utf8_encode(NSString *string) {
 - (id<STArrival>)checkArrival:(id<STArrival>)income {
     NSAssert([income isKindOfClass:[STPlainArrival class]], @"arrival ship error: %@", income);
     NSData *data = [(STPlainArrival *)income package];
+    NSTimeInterval now = OKGetCurrentTimeInterval();
+    _lastActive = now;
     if ([data length] == 4) {
-        if ([data isEqualToData:utf8_encode(PING)]) {
+        if (is_control(data, control_ping)) {
             // PING -> PONG
-            [self sendData:utf8_encode(PONG)
-                  priority:STDeparturePrioritySlower];
+            [self sendData:pong_data priority:STDeparturePrioritySlower];
             return nil;
-        } else if ([data isEqualToData:utf8_encode(PONG)] ||
-                   [data isEqualToData:utf8_encode(NOOP)]) {
+        } else if (is_control(data, control_pong)) {
+            [self updateRoundTripTime:now];
+            return nil;
+        } else if (is_control(data, control_noop)) {
             // ignore
             return nil;
         }
@@ -85,6 +128,31 @@ static inline NSData *utf8_encode(NSString *string) {
     return income;
 }
 
+// private
+- (void)updateRoundTripTime:(NSTimeInterval)now {
+    if (_pingTime <= 0) {
+        // not for my PING
+        return;
+    }
+    NSTimeInterval sample = now - _pingTime;
+    _pingTime = 0;
+    _pongCount += 1;
+    if (_pingRetried) {
+        // can't tell which PING this PONG answers, skip the sample (Karn)
+        _pingRetried = NO;
+        return;
+    }
+    _lastRoundTripTime = sample;
+    // smoothed as TCP does (RFC 6298)
+    if (_roundTripTime < 0) {
+        _roundTripTime = sample;
+        _jitter = sample / 2;
+    } else {
+        _jitter = _jitter * 0.75 + fabs(_roundTripTime - sample) * 0.25;
+        _roundTripTime = _roundTripTime * 0.875 + sample * 0.125;
+    }
+}
+
 //
 //  Sending
 //
@@ -102,24 +170,58 @@ static inline NSData *utf8_encode(NSString *string) {
 
 // Override
 - (void)heartbeat {
-    [self sendData:utf8_encode(PING) priority:STDeparturePrioritySlower];
+    NSTimeInterval now = OKGetCurrentTimeInterval();
+    if (_pingTime > 0) {
+        // last PING not answered, probe faster
+        _heartbeatInterval = STHeartbeatMinInterval;
+        if (now - _lastPingTime < _heartbeatInterval) {
+            // too frequently
+            return;
+        }
+        // keep the time of the first PING
+        _pingRetried = YES;
+    } else if (now - _lastActive < _heartbeatInterval) {
+        // traffic is flowing, no need to probe now
+        _heartbeatInterval = MIN(_heartbeatInterval * 2, STHeartbeatMaxInterval);
+        return;
+    } else if (now - _lastPingTime < _heartbeatInterval) {
+        // too frequently
+        return;
+    } else {
+        _pingTime = now;
+    }
+    _lastPingTime = now;
+    _pingCount += 1;
+    [self sendData:ping_data priority:STDeparturePrioritySlower];
 }
 
 @end
 
+@interface STStreamDocker ()
+
+@property(nonatomic, strong) STStreamFramer *framer;
+
+@end
+
 @implementation STStreamDocker
 
-// Override
-- (void)processReceivedData:(NSData *)data {
-    // TODO: the cached data maybe contain sticky packages,
-    //       so we need to process them circularly here
-    [super processReceivedData:data];
+- (instancetype)initWithConnection:(id<STConnection>)conn {
+    if (self = [super initWithConnection:conn]) {
+        self.framer = [[STStreamFramer alloc] init];
+        _binaryFraming = NO;
+    }
+    return self;
 }
 
 // Override
-- (id<STArrival>)checkArrival:(id<STArrival>)income {
-    // TODO: check sticky data
-    return [super checkArrival:income];
+- (void)processReceivedData:(NSData *)data {
+    // the received data maybe contain sticky packages,
+    // or only a part of the package, so we need to reassemble
+    // them before processing one by one
+    NSArray<NSData *> *frames = [_framer framesWithData:data];
+    for (NSData *pack in frames) {
+        [super processReceivedData:pack];
+    }
 }
 
 // Override
@@ -129,7 +231,9 @@ static inline NSData *utf8_encode(NSString *string) {
 
 // Override
 - (id<STDeparture>)createDepartureWithData:(NSData *)pack priority:(NSInteger)prior {
-    // TODO: check pack type?
+    if (_binaryFraming) {
+        pack = [STStreamFramer binaryFrameWithData:pack];
+    }
     return [[STStreamDeparture alloc] initWithData:pack priority:prior];
 }
 
@@ -0,0 +1,119 @@
+// license: https://mit-license.org
+//
+//  Star Gate: Network Connection Module
+//
+//                               Written in 2026 by agent <agent@local>
+//
+// =============================================================================
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// =============================================================================
+//
+//  STStreamFramer.h
+//  DIMClient
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(UInt8, STStreamFormat) {
+    STStreamFormatUnknown = 0,  // not enough bytes to decide
+    STStreamFormatJSON,         // JSON lines
+    STStreamFormatMars,         // "Mars SN:" head line + JSON
+    STStreamFormatText,         // control words or other text lines
+    STStreamFormatBinary,       // binary frames
+};
+
+// binary frame: magic (1 byte) + body length (4 bytes, big-endian) + body
+#define STBinaryFrameMagic      0xDB
+#define STBinaryFrameHeadLength 5
+
+/**
+ *  Stream Framer
+ *  ~~~~~~~~~~~~~
+ *
+ *  Reassemble complete packages from a TCP stream,
+ *  the received data may contain sticky or partial packages.
+ *
+ *  Frames:
+ *      1. JSON object, ends at the closing '}' of the top level;
+ *      2. "Mars SN:...\n" head line, followed by JSON objects (one per line),
+ *         ends before the next non-JSON byte, or at the end of received data;
+ *      3. control words: "PING", "PONG", "NOOP";
+ *      4. binary frame, magic byte + body length + body;
+ *      5. any other text, ends at '\n'.
+ *
+ *  The unfinished tail will be cached for next time, only the new
+ *  incoming bytes will be scanned, and each byte is copied once at most;
+ *  the complete frames are sliced from the received data without copying.
+ */
+@interface STStreamFramer : NSObject
+
+// bytes cached for the unfinished frame
+@property(nonatomic, readonly) NSUInteger cachedLength;
+
+// max length of the unfinished frame, drop it when exceeded
+@property(nonatomic, assign) NSUInteger maxLength;
+
+/**
+ *  Append received data and fetch the completed frames
+ *
+ * @param data - received data
+ * @return complete frames
+ */
+- (NSArray<NSData *> *)framesWithData:(NSData *)data;
+
+/**
+ *  Drop the unfinished frame
+ */
+- (void)reset;
+
+/**
+ *  Check the first bytes of a stream to decide its format
+ *
+ * @param parts - data received in order
+ * @return STStreamFormatUnknown when need more bytes
+ */
++ (STStreamFormat)formatOfData:(NSArray<NSData *> *)parts;
+
+/**
+ *  Pack body into a binary frame, the body will not be copied
+ *
+ * @param body - frame body
+ * @return binary frame
+ */
++ (NSData *)binaryFrameWithData:(NSData *)body;
+
+/**
+ *  Get body from a binary frame, the body will not be copied
+ *
+ * @param frame - binary frame, or plain package
+ * @return frame body, or the package itself when it's not a binary frame
+ */
++ (NSData *)bodyOfBinaryFrame:(NSData *)frame;
+
+@end
+
+NS_ASSUME_NONNULL_END
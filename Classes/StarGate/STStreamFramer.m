@@ -0,0 +1,503 @@
+// license: https://mit-license.org
+//
+//  Star Gate: Network Connection Module
+//
+//                               Written in 2026 by agent <agent@local>
+//
+// =============================================================================
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 agent
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// =============================================================================
+//
+//  STStreamFramer.m
+//  DIMClient
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import "STStreamFramer.h"
+
+typedef NS_ENUM(UInt8, STFrameMode) {
+    STFrameModeBegin = 0,  // waiting for the first byte of body
+    STFrameModeJSON,       // JSON object/array
+    STFrameModeText,       // text line
+    STFrameModeBinary,     // length-prefixed body
+    STFrameModeMars,       // between JSON lines of a Mars body
+};
+
+typedef struct {
+    NSUInteger lines;      // head lines to skip
+    NSUInteger depth;      // nesting level of JSON brackets
+    NSUInteger remaining;  // bytes left of the binary frame
+    STFrameMode mode;
+    BOOL quoted;           // inside a JSON string
+    BOOL escaped;          // last char is '\\' in JSON string
+    BOOL multi;            // Mars body, may contain several JSON lines
+} STFrameState;
+
+static const unsigned char sn_head[] = "Mars SN:";
+static const unsigned char *control_words[] = {
+    (const unsigned char *)"PING",
+    (const unsigned char *)"PONG",
+    (const unsigned char *)"NOOP",
+};
+
+static inline void state_reset(STFrameState *st) {
+    st->lines = 0;
+    st->depth = 0;
+    st->remaining = 0;
+    st->mode = STFrameModeBegin;
+    st->quoted = NO;
+    st->escaped = NO;
+    st->multi = NO;
+}
+
+// wrap data buffer without copying, the data will be retained until
+// all the slices are released
+static inline dispatch_data_t wrap_data(NSData *data) {
+    return dispatch_data_create([data bytes], [data length], NULL, ^{
+        [data length];
+    });
+}
+
+static inline BOOL is_space(unsigned char ch) {
+    return ch == '\n' || ch == '\r' || ch == ' ' || ch == '\t';
+}
+
+// check whether the buffer starts with (or is a part of) the prefix
+static inline NSInteger match_prefix(const unsigned char *buf, NSUInteger len,
+                                     const unsigned char *prefix, NSUInteger size) {
+    NSUInteger cnt = len < size ? len : size;
+    if (memcmp(buf, prefix, cnt) != 0) {
+        return -1;  // not match
+    }
+    return cnt == size ? 1 : 0;  // 0 means need more bytes
+}
+
+/**
+ *  Scan bytes for the end of current frame
+ *
+ * @return position after the frame end; NSNotFound when need more bytes
+ */
+static inline NSUInteger frame_scan(STFrameState *st, const unsigned char *buf, NSUInteger len) {
+    if (st->mode == STFrameModeBinary) {
+        // no need to scan the body
+        if (len >= st->remaining) {
+            return st->remaining;
+        }
+        st->remaining -= len;
+        return NSNotFound;
+    }
+    unsigned char ch;
+    for (NSUInteger i = 0; i < len; ++i) {
+        ch = buf[i];
+        if (st->lines > 0) {
+            // skip head line
+            if (ch == '\n') {
+                --st->lines;
+            }
+            continue;
+        }
+        switch (st->mode) {
+            case STFrameModeBegin:
+                if (ch == '{' || ch == '[') {
+                    st->mode = STFrameModeJSON;
+                    st->depth = 1;
+                } else if (ch == '\n') {
+                    // empty body
+                    return i + 1;
+                } else if (!is_space(ch)) {
+                    st->mode = STFrameModeText;
+                }
+                break;
+                
+            case STFrameModeJSON:
+                if (st->quoted) {
+                    if (st->escaped) {
+                        st->escaped = NO;
+                    } else if (ch == '\\') {
+                        st->escaped = YES;
+                    } else if (ch == '"') {
+                        st->quoted = NO;
+                    }
+                } else if (ch == '"') {
+                    st->quoted = YES;
+                } else if (ch == '{' || ch == '[') {
+                    ++st->depth;
+                } else if (ch == '}' || ch == ']') {
+                    if (--st->depth == 0) {
+                        // top level closed
+                        if (st->multi) {
+                            // more JSON lines may follow in the Mars body
+                            st->mode = STFrameModeMars;
+                            break;
+                        }
+                        return i + 1;
+                    }
+                }
+                break;
+                
+            case STFrameModeMars:
+                if (ch == '{' || ch == '[') {
+                    st->mode = STFrameModeJSON;
+                    st->depth = 1;
+                } else if (!is_space(ch)) {
+                    // next frame begins here
+                    return i;
+                }
+                break;
+                
+            case STFrameModeText:
+                if (ch == '\n') {
+                    return i + 1;
+                }
+                break;
+                
+            case STFrameModeBinary:
+                break;
+        }
+    }
+    if (st->mode == STFrameModeMars) {
+        // all received JSON lines of the Mars body are closed,
+        // take them together with the head as one frame
+        return len;
+    }
+    return NSNotFound;
+}
+
+static inline NSUInteger read_length(const unsigned char *buf) {
+    return ((NSUInteger)buf[0] << 24) | ((NSUInteger)buf[1] << 16) |
+           ((NSUInteger)buf[2] << 8) | (NSUInteger)buf[3];
+}
+
+// length without the tailing '\n' or '\r\n'
+static inline NSUInteger trim_length(const unsigned char *buf, NSUInteger len) {
+    while (len > 0 && (buf[len - 1] == '\n' || buf[len - 1] == '\r')) {
+        --len;
+    }
+    return len;
+}
+
+// decide stream format by the leading bytes
+static inline STStreamFormat format_sniff(const unsigned char *buf, NSUInteger len) {
+    NSUInteger pos = 0;
+    while (pos < len && is_space(buf[pos])) {
+        ++pos;
+    }
+    if (pos == len) {
+        return STStreamFormatUnknown;
+    }
+    buf += pos;
+    len -= pos;
+    unsigned char ch = buf[0];
+    if (ch == '{' || ch == '[') {
+        return STStreamFormatJSON;
+    } else if (ch < 0x20 || ch >= 0x80) {
+        return STStreamFormatBinary;
+    }
+    NSInteger matched = match_prefix(buf, len, sn_head, 8);
+    if (matched > 0) {
+        return STStreamFormatMars;
+    } else if (matched == 0) {
+        return STStreamFormatUnknown;
+    }
+    for (NSUInteger i = 0; i < 3; ++i) {
+        if (match_prefix(buf, len, control_words[i], 4) == 0) {
+            return STStreamFormatUnknown;
+        }
+    }
+    return STStreamFormatText;
+}
+
+@interface STStreamFramer () {
+    
+    NSMutableData *_cache;  // unfinished frame
+    STFrameState _state;
+    
+    BOOL _undetermined;     // cached bytes not enough to decide the frame type
+    BOOL _discarding;       // frame too long, skip till its end
+}
+
+@end
+
+@implementation STStreamFramer
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _cache = [[NSMutableData alloc] init];
+        state_reset(&_state);
+        _undetermined = NO;
+        _discarding = NO;
+        _maxLength = 1 << 22;  // 4 MB
+    }
+    return self;
+}
+
+- (NSUInteger)cachedLength {
+    return [_cache length];
+}
+
+- (void)reset {
+    _cache = [[NSMutableData alloc] init];
+    state_reset(&_state);
+    _undetermined = NO;
+    _discarding = NO;
+}
+
+- (NSArray<NSData *> *)framesWithData:(NSData *)data {
+    NSMutableArray<NSData *> *frames = [[NSMutableArray alloc] init];
+    if ([data length] == 0) {
+        return frames;
+    }
+    NSUInteger pos = 0;
+    if (_undetermined) {
+        // rarely happens: only a few head bytes were cached last time,
+        // join them with the new data and parse again
+        [_cache appendData:data];
+        data = _cache;
+        [self reset];
+    } else if ([_cache length] > 0 || _discarding) {
+        // finish the cached frame
+        pos = [self finishFrameWithData:data frames:frames];
+        if (pos == NSNotFound) {
+            // need more bytes
+            return frames;
+        }
+    }
+    [self splitData:data offset:pos frames:frames];
+    return frames;
+}
+
++ (STStreamFormat)formatOfData:(NSArray<NSData *> *)parts {
+    // only a few leading bytes are needed after the blanks,
+    // gather them from the parts without joining the whole data
+    unsigned char buffer[16];
+    NSUInteger len = 0, cnt;
+    const unsigned char *bytes;
+    STStreamFormat format = STStreamFormatUnknown;
+    for (NSData *item in parts) {
+        bytes = [item bytes];
+        cnt = [item length];
+        while (cnt > 0) {
+            if (len == 0 && is_space(*bytes)) {
+                ++bytes;
+                --cnt;
+                continue;
+            }
+            buffer[len++] = *bytes++;
+            --cnt;
+            if (len == sizeof(buffer)) {
+                break;
+            }
+        }
+        format = format_sniff(buffer, len);
+        if (format != STStreamFormatUnknown || len == sizeof(buffer)) {
+            break;
+        }
+    }
+    return format;
+}
+
++ (NSData *)binaryFrameWithData:(NSData *)body {
+    NSUInteger length = [body length];
+    unsigned char head[STBinaryFrameHeadLength] = {
+        STBinaryFrameMagic,
+        (length >> 24) & 0xFF, (length >> 16) & 0xFF, (length >> 8) & 0xFF, length & 0xFF,
+    };
+    dispatch_data_t frame = dispatch_data_create(head, sizeof(head), NULL,
+                                                 DISPATCH_DATA_DESTRUCTOR_DEFAULT);
+    dispatch_data_t part = dispatch_data_create([body bytes], length, NULL, ^{
+        [body length];
+    });
+    return (NSData *)dispatch_data_create_concat(frame, part);
+}
+
++ (NSData *)bodyOfBinaryFrame:(NSData *)frame {
+    NSUInteger length = [frame length];
+    if (length < STBinaryFrameHeadLength) {
+        return frame;
+    }
+    const unsigned char *bytes = [frame bytes];
+    if (bytes[0] != STBinaryFrameMagic) {
+        return frame;
+    }
+    UInt32 size = ((UInt32)bytes[1] << 24) | ((UInt32)bytes[2] << 16) | ((UInt32)bytes[3] << 8) | bytes[4];
+    if (size != length - STBinaryFrameHeadLength) {
+        NSAssert(false, @"binary frame length error: %u, %lu", size, length);
+        return frame;
+    }
+    dispatch_data_t whole = dispatch_data_create(bytes, length, NULL, ^{
+        [frame length];
+    });
+    return (NSData *)dispatch_data_create_subrange(whole, STBinaryFrameHeadLength, size);
+}
+
+// private
+- (NSUInteger)finishFrameWithData:(NSData *)data frames:(NSMutableArray *)frames {
+    const unsigned char *bytes = [data bytes];
+    NSUInteger length = [data length];
+    NSUInteger end = frame_scan(&_state, bytes, length);
+    if (end == NSNotFound) {
+        [self cacheBytes:bytes length:length];
+        return NSNotFound;
+    }
+    if (_discarding) {
+        NSLog(@"[Framer] dropped a long frame");
+    } else if (_state.mode == STFrameModeBinary) {
+        [_cache appendBytes:bytes length:end];
+        // skip the frame head without moving the body
+        NSUInteger len = _cache.length - STBinaryFrameHeadLength;
+        if (len > 0) {
+            [frames addObject:(NSData *)dispatch_data_create_subrange(wrap_data(_cache),
+                                                                      STBinaryFrameHeadLength, len)];
+        }
+    } else {
+        [_cache appendBytes:bytes length:end];
+        NSUInteger len = _cache.length;
+        if (_state.mode == STFrameModeText || _state.mode == STFrameModeMars) {
+            len = trim_length(_cache.bytes, len);
+            [_cache setLength:len];
+        }
+        if (len > 0) {
+            [frames addObject:_cache];
+        }
+    }
+    [self reset];
+    return end;
+}
+
+// private
+- (void)splitData:(NSData *)data offset:(NSUInteger)pos frames:(NSMutableArray *)frames {
+    const unsigned char *bytes = [data bytes];
+    NSUInteger length = [data length];
+    dispatch_data_t whole = nil;
+    NSUInteger end, len;
+    NSInteger matched;
+    BOOL found;
+    while (pos < length) {
+        // 1. skip blank
+        if (is_space(bytes[pos])) {
+            ++pos;
+            continue;
+        }
+        // 2. check binary frame
+        if (bytes[pos] == STBinaryFrameMagic) {
+            if (length - pos < STBinaryFrameHeadLength) {
+                // wait for the whole head
+                _undetermined = YES;
+                [_cache appendBytes:(bytes + pos) length:(length - pos)];
+                return;
+            }
+            len = read_length(bytes + pos + 1);
+            _state.mode = STFrameModeBinary;
+            _state.remaining = STBinaryFrameHeadLength + len;
+            end = frame_scan(&_state, bytes + pos, length - pos);
+            if (end == NSNotFound) {
+                // partial frame, cache it for next time
+                [self cacheBytes:(bytes + pos) length:(length - pos)];
+                return;
+            }
+            if (len > 0) {
+                [frames addObject:[self slice:data whole:&whole
+                                        range:NSMakeRange(pos + STBinaryFrameHeadLength, len)]];
+            }
+            state_reset(&_state);
+            pos += end;
+            continue;
+        }
+        // 3. check control words
+        found = NO;
+        _undetermined = NO;
+        for (NSUInteger i = 0; i < 3; ++i) {
+            matched = match_prefix(bytes + pos, length - pos, control_words[i], 4);
+            if (matched > 0) {
+                [frames addObject:[self slice:data whole:&whole range:NSMakeRange(pos, 4)]];
+                pos += 4;
+                found = YES;
+                break;
+            } else if (matched == 0) {
+                _undetermined = YES;
+            }
+        }
+        if (found) {
+            continue;
+        }
+        // 4. check SN head
+        matched = match_prefix(bytes + pos, length - pos, sn_head, 8);
+        if (matched > 0) {
+            _state.lines = 1;
+            _state.multi = YES;
+        } else if (matched == 0) {
+            _undetermined = YES;
+        }
+        if (_undetermined) {
+            // wait for more bytes to decide
+            [_cache appendBytes:(bytes + pos) length:(length - pos)];
+            return;
+        }
+        // 5. scan for frame end
+        end = frame_scan(&_state, bytes + pos, length - pos);
+        if (end == NSNotFound) {
+            // partial frame, cache it for next time
+            [self cacheBytes:(bytes + pos) length:(length - pos)];
+            return;
+        }
+        len = end;
+        if (_state.mode == STFrameModeText || _state.mode == STFrameModeMars) {
+            len = trim_length(bytes + pos, len);
+        }
+        if (len > 0) {
+            [frames addObject:[self slice:data whole:&whole range:NSMakeRange(pos, len)]];
+        }
+        state_reset(&_state);
+        pos += end;
+    }
+}
+
+// private
+- (NSData *)slice:(NSData *)data whole:(dispatch_data_t *)whole range:(NSRange)range {
+    if (range.location == 0 && range.length == data.length) {
+        // whole package
+        return data;
+    }
+    if (!*whole) {
+        // wrap once for all slices of this data
+        *whole = wrap_data(data);
+    }
+    return (NSData *)dispatch_data_create_subrange(*whole, range.location, range.length);
+}
+
+// private
+- (void)cacheBytes:(const unsigned char *)bytes length:(NSUInteger)length {
+    if (_discarding) {
+        return;
+    }
+    if (_cache.length + length > _maxLength) {
+        NSLog(@"[Framer] frame too long: %lu + %lu > %lu", _cache.length, length, _maxLength);
+        _cache = [[NSMutableData alloc] init];
+        _discarding = YES;
+        return;
+    }
+    [_cache appendBytes:bytes length:length];
+}
+
+@end
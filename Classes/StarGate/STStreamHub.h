@@ -41,9 +41,19 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface STStreamHub : STHub
 
+// tuning profile for new sockets, applied before connecting
+@property(nonatomic, strong, nullable) STSocketOptions *socketOptions;
+
 // protected
 - (STAddressPairMap<id<STChannel>> *)createChannelPool;
 
+/**
+ *  Get native handles of all opened sockets for waiting readiness
+ *
+ * @return file descriptors
+ */
+- (NSArray<NSNumber *> *)socketDescriptors;
+
 @end
 
 // protected
@@ -61,6 +71,23 @@ NS_ASSUME_NONNULL_BEGIN
                                   remoteAddress:(id<NIOSocketAddress>)remote
                                    localAddress:(nullable id<NIOSocketAddress>)local;
 
+/**
+ *  Create channel with socket & addresses, and keep the native handle
+ *  of the socket in it for tuning & waiting readiness
+ *
+ * @param sock    - socket
+ * @param fd      - native handle of the socket; -1 when not available
+ * @param applied - socket options applied before connecting
+ * @param remote  - remote address
+ * @param local   - local address
+ * @return null on socket error
+ */
+- (id<STChannel>)createChannelWithSocketChannel:(NIOSocketChannel *)sock
+                               socketDescriptor:(int)fd
+                                  socketOptions:(nullable STSocketOptions *)applied
+                                  remoteAddress:(id<NIOSocketAddress>)remote
+                                   localAddress:(nullable id<NIOSocketAddress>)local;
+
 - (id<STChannel>)channelForRemoteAddress:(id<NIOSocketAddress>)remote
                             localAddress:(nullable id<NIOSocketAddress>)local;
 
@@ -72,10 +99,26 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface STClientHub : STStreamHub
 
+/**
+ *  Open a socket and connect it to the remote address
+ *
+ *  Call 'prepareSocket:' after the socket opened and before connecting,
+ *  then create the channel with the handle and the options applied.
+ */
 // protected
 - (id<STChannel>)createSocketChannelForRemoteAddress:(id<NIOSocketAddress>)remote
                                         localAddress:(id<NIOSocketAddress>)local;
 
+/**
+ *  Apply the tuning profile to a socket not connected yet,
+ *  the buffer sizes must be set before connecting for the TCP window scale
+ *
+ * @param fd - native handle of the socket
+ * @return values actually applied; nil when no profile
+ */
+// protected
+- (nullable STSocketOptions *)prepareSocket:(int)fd;
+
 @end
 
 @interface STStreamClientHub : STClientHub
@@ -86,6 +86,21 @@
     return [[__ChannelPool alloc] init];
 }
 
+- (NSArray<NSNumber *> *)socketDescriptors {
+    NSMutableArray *array = [[NSMutableArray alloc] init];
+    int fd;
+    for (id<STChannel> channel in [_channelPool allValues]) {
+        if (![channel isKindOfClass:[STStreamChannel class]] || ![channel isOpen]) {
+            continue;
+        }
+        fd = [(STStreamChannel *)channel socketDescriptor];
+        if (fd >= 0) {
+            [array addObject:@(fd)];
+        }
+    }
+    return array;
+}
+
 @end
 
 @implementation STStreamHub (Channel)
@@ -93,9 +108,24 @@
 - (id<STChannel>)createChannelWithSocketChannel:(NIOSocketChannel *)sock
                                   remoteAddress:(id<NIOSocketAddress>)remote
                                    localAddress:(nullable id<NIOSocketAddress>)local {
-    return [[STStreamChannel alloc] initWithSocket:sock
-                                     remoteAddress:remote
-                                      localAddress:local];
+    return [self createChannelWithSocketChannel:sock
+                               socketDescriptor:-1
+                                  socketOptions:nil
+                                  remoteAddress:remote
+                                   localAddress:local];
+}
+
+- (id<STChannel>)createChannelWithSocketChannel:(NIOSocketChannel *)sock
+                               socketDescriptor:(int)fd
+                                  socketOptions:(nullable STSocketOptions *)applied
+                                  remoteAddress:(id<NIOSocketAddress>)remote
+                                   localAddress:(nullable id<NIOSocketAddress>)local {
+    STStreamChannel *channel = [[STStreamChannel alloc] initWithSocket:sock
+                                                         remoteAddress:remote
+                                                          localAddress:local];
+    [channel setSocketDescriptor:fd];
+    [channel setSocketOptions:applied];
+    return channel;
 }
 
 // Override
@@ -111,6 +141,13 @@
 - (void)setChannel:(id<STChannel>)channel
      remoteAddress:(id<NIOSocketAddress>)remote
       localAddress:(nullable id<NIOSocketAddress>)local {
+    STSocketOptions *options = [self socketOptions];
+    if (options && [channel isKindOfClass:[STStreamChannel class]] &&
+        ![(STStreamChannel *)channel socketOptions]) {
+        // connected without preparing, the buffer sizes may be too late
+        // for the window scale, but others still work
+        [(STStreamChannel *)channel applySocketOptions:options];
+    }
     [_channelPool setObject:channel forRemote:remote local:local];
 }
 
@@ -171,6 +208,17 @@
     return nil;
 }
 
+// protected
+- (nullable STSocketOptions *)prepareSocket:(int)fd {
+    STSocketOptions *options = [self socketOptions];
+    if (!options) {
+        return nil;
+    }
+    STSocketOptions *applied = [options applyToSocket:fd];
+    NSLog(@"[SOCKET] options applied before connecting: %@", applied);
+    return applied;
+}
+
 @end
 
 @implementation STStreamClientHub
@@ -65,9 +65,11 @@
 #import <DIMClient/DIMClientSession+State.h>
 #import <DIMClient/DIMClientMessagePacker.h>
 #import <DIMClient/DIMClientMessageProcessor.h>
+#import <DIMClient/DIMOutbox.h>
 #import <DIMClient/DIMClientMessenger.h>
 #import <DIMClient/DIMClientArchivist.h>
 #import <DIMClient/DIMClientFacebook.h>
 #import <DIMClient/DIMTerminal.h>
+#import <DIMClient/DIMStationRacer.h>
 
 #endif /* ! __DIM_CLIENT__ */
@@ -52,7 +52,9 @@
 
 #import <DIMClient/DIMAccountUtils.h>
 #import <DIMClient/DIMMessageUtils.h>
+#import <DIMClient/DIMLazyEnvelope.h>
 #import <DIMClient/DIMCache.h>
+#import <DIMClient/DIMDuplicateFilter.h>
 #import <DIMClient/DIMCheckers.h>
 #import <DIMClient/DIMDigestX.h>
 
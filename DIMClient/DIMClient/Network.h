@@ -48,12 +48,17 @@
 #import <DIMClient/STStreamArrival.h>
 #import <DIMClient/STStreamDeparture.h>
 #import <DIMClient/STStreamDocker.h>
+#import <DIMClient/STStreamFramer.h>
+#import <DIMClient/STSocketOptions.h>
 
 //
 //  Network
 //
 
 #import <DIMClient/DIMWrapperQueue.h>
+#import <DIMClient/DIMTokenBucket.h>
+#import <DIMClient/DIMReconnectScheduler.h>
+#import <DIMClient/DIMOutboxJournal.h>
 #import <DIMClient/DIMGateKeeper.h>
 #import <DIMClient/DIMBaseSession.h>
 #import <DIMClient/DIMFileTask.h>
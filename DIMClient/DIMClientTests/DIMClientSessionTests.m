@@ -0,0 +1,108 @@
+//
+//  DIMClientSessionTests.m
+//  DIMClientTests
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import <XCTest/XCTest.h>
+#import <malloc/malloc.h>
+
+#import <DIMClient/DIMClient.h>
+
+#define BURST_BYTES   (10 << 20)  // 10 MB in one arrival
+#define MESSAGE_SIZE  1024        // with the '\n'
+#define BURST_COUNT   (BURST_BYTES / MESSAGE_SIZE)
+
+static inline NSData *create_burst(void) {
+    NSMutableData *mData = [[NSMutableData alloc] initWithCapacity:(BURST_BYTES + 64)];
+    [mData appendData:MKUTF8Encode(@"Mars SN:1234567890\n")];
+    NSString *head;
+    NSMutableData *line;
+    for (NSUInteger index = 0; index < BURST_COUNT; ++index) {
+        head = [NSString stringWithFormat:@"{\"sn\":%lu,\"data\":\"", index];
+        line = [[NSMutableData alloc] initWithData:MKUTF8Encode(head)];
+        // pad the body, leave 3 bytes for '"}\n'
+        [line setLength:(MESSAGE_SIZE - 3)];
+        memset((char *)[line mutableBytes] + [head length], 'A', MESSAGE_SIZE - 3 - [head length]);
+        [line appendBytes:"\"}\n" length:3];
+        [mData appendData:line];
+    }
+    return mData;
+}
+
+static inline malloc_statistics_t malloc_stats(void) {
+    malloc_statistics_t stats;
+    malloc_zone_statistics(NULL, &stats);
+    return stats;
+}
+
+@interface DIMClientSessionTests : XCTestCase
+
+@end
+
+@implementation DIMClientSessionTests
+
+- (void)setUp {
+    [DIMClientFacebook prepare];
+}
+
+- (void)testSplitBurst {
+    NSData *burst = create_burst();
+    STStreamArrival *arrival = [[STStreamArrival alloc] initWithData:burst];
+    NSArray<NSData *> *packages = [DIMClientSession fetchDataPackages:arrival];
+    XCTAssertEqual([packages count], BURST_COUNT);
+    NSData *first = [packages firstObject];
+    XCTAssertEqual([first length], MESSAGE_SIZE - 1);
+    XCTAssertEqual(((const char *)[first bytes])[0], '{');
+    NSDictionary *info = [NSJSONSerialization JSONObjectWithData:[packages lastObject]
+                                                         options:0 error:nil];
+    XCTAssertEqualObjects([info objectForKey:@"sn"], @(BURST_COUNT - 1));
+}
+
+// allocations & bytes held by the packages of one burst,
+// compared with copying every line out of the payload
+- (void)testAllocationsOfBurst {
+    NSData *burst = create_burst();
+    STStreamArrival *arrival = [[STStreamArrival alloc] initWithData:burst];
+    malloc_statistics_t before, after;
+    size_t sliced, copied;
+    @autoreleasepool {
+        before = malloc_stats();
+        NSArray<NSData *> *packages = [DIMClientSession fetchDataPackages:arrival];
+        after = malloc_stats();
+        sliced = after.size_in_use - before.size_in_use;
+        NSLog(@"[SESSION] sliced %lu packages: %lu allocation(s), %lu byte(s)",
+              [packages count], after.blocks_in_use - before.blocks_in_use, sliced);
+    }
+    @autoreleasepool {
+        before = malloc_stats();
+        NSMutableArray<NSData *> *packages = [[NSMutableArray alloc] initWithCapacity:BURST_COUNT];
+        const char *buffer = [burst bytes];
+        const char *start = memchr(buffer, '\n', [burst length]) + 1;
+        const char *end;
+        while ((end = memchr(start, '\n', buffer + [burst length] - start))) {
+            [packages addObject:[[NSData alloc] initWithBytes:start length:(end - start)]];
+            start = end + 1;
+        }
+        after = malloc_stats();
+        copied = after.size_in_use - before.size_in_use;
+        NSLog(@"[SESSION] copied %lu packages: %lu allocation(s), %lu byte(s)",
+              [packages count], after.blocks_in_use - before.blocks_in_use, copied);
+    }
+    // the slices only hold their headers, the bodies stay in the payload
+    XCTAssertLessThan(sliced, BURST_BYTES / 4);
+    XCTAssertGreaterThan(copied, BURST_BYTES - MESSAGE_SIZE);
+}
+
+- (void)testPerformanceSplitBurst {
+    NSData *burst = create_burst();
+    STStreamArrival *arrival = [[STStreamArrival alloc] initWithData:burst];
+    [self measureBlock:^{
+        @autoreleasepool {
+            [DIMClientSession fetchDataPackages:arrival];
+        }
+    }];
+}
+
+@end
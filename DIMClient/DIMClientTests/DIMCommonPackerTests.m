@@ -0,0 +1,247 @@
+//
+//  DIMCommonPackerTests.m
+//  DIMClientTests
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import <XCTest/XCTest.h>
+
+#import <DIMClient/DIMClient.h>
+
+#define CONTACTS  1000
+#define SENDS     100000
+
+// accounts in memory only
+@interface __MemoryDatabase : NSObject <DIMAccountDBI> {
+
+    NSMutableDictionary<NSString *, id<MKMMeta>> *_metas;
+    NSMutableDictionary<NSString *, NSArray<id<MKMDocument>> *> *_documents;
+}
+
+@end
+
+@implementation __MemoryDatabase
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _metas = [[NSMutableDictionary alloc] init];
+        _documents = [[NSMutableDictionary alloc] init];
+    }
+    return self;
+}
+
+- (BOOL)savePrivateKey:(id<MKPrivateKey>)key withType:(NSString *)type forUser:(id<MKMID>)user {
+    return NO;
+}
+
+- (NSArray<id<MKDecryptKey>> *)privateKeysForDecryption:(id<MKMID>)user {
+    return @[];
+}
+
+- (nullable id<MKPrivateKey>)privateKeyForSignature:(id<MKMID>)user {
+    return nil;
+}
+
+- (nullable id<MKPrivateKey>)privateKeyForVisaSignature:(id<MKMID>)user {
+    return nil;
+}
+
+- (BOOL)saveMeta:(id<MKMMeta>)meta forID:(id<MKMID>)entity {
+    @synchronized (self) {
+        [_metas setObject:meta forKey:entity.string];
+    }
+    return YES;
+}
+
+- (nullable id<MKMMeta>)metaForID:(id<MKMID>)entity {
+    @synchronized (self) {
+        return [_metas objectForKey:entity.string];
+    }
+}
+
+- (BOOL)saveDocument:(id<MKMDocument>)doc forID:(id<MKMID>)entity {
+    // keep the last one only
+    @synchronized (self) {
+        [_documents setObject:@[doc] forKey:entity.string];
+    }
+    return YES;
+}
+
+- (NSArray<id<MKMDocument>> *)documentsForID:(id<MKMID>)entity {
+    @synchronized (self) {
+        NSArray *docs = [_documents objectForKey:entity.string];
+        return docs ? docs : @[];
+    }
+}
+
+- (NSArray<id<MKMID>> *)localUsers {
+    return @[];
+}
+
+- (BOOL)saveLocalUsers:(NSArray<id<MKMID>> *)users {
+    return NO;
+}
+
+- (NSArray<id<MKMID>> *)contactsOfUser:(id<MKMID>)user {
+    return @[];
+}
+
+- (BOOL)saveContacts:(NSArray<id<MKMID>> *)contacts forUser:(id<MKMID>)user {
+    return NO;
+}
+
+- (nullable id<MKMID>)founderOfGroup:(id<MKMID>)gid {
+    return nil;
+}
+
+- (nullable id<MKMID>)ownerOfGroup:(id<MKMID>)gid {
+    return nil;
+}
+
+- (NSArray<id<MKMID>> *)membersOfGroup:(id<MKMID>)gid {
+    return @[];
+}
+
+- (BOOL)saveMembers:(NSArray<id<MKMID>> *)members forGroup:(id<MKMID>)gid {
+    return NO;
+}
+
+- (NSArray<id<MKMID>> *)administratorsOfGroup:(id<MKMID>)gid {
+    return @[];
+}
+
+- (BOOL)saveAdministrators:(NSArray<id<MKMID>> *)admins forGroup:(id<MKMID>)gid {
+    return NO;
+}
+
+- (BOOL)saveGroupHistory:(id<DKDGroupCommand>)content
+             withMessage:(id<DKDReliableMessage>)rMsg
+                forGroup:(id<MKMID>)gid {
+    return NO;
+}
+
+- (NSArray<DIMHistoryCmdMsg *> *)historiesOfGroup:(id<MKMID>)group {
+    return @[];
+}
+
+- (DIMResetCmdMsg *)resetCommandMessageForGroup:(id<MKMID>)group {
+    return [[OKPair alloc] initWithFirst:nil second:nil];
+}
+
+- (BOOL)clearMemberHistoriesOfGroup:(id<MKMID>)group {
+    return NO;
+}
+
+- (BOOL)clearAdminHistoriesOfGroup:(id<MKMID>)group {
+    return NO;
+}
+
+@end
+
+static inline id<MKMVisa> create_visa(id<MKMID> uid, id<MKEncryptKey> visaKey,
+                                      id<MKSignKey> idKey, NSTimeInterval time) {
+    id<MKMVisa> visa = [[DIMVisa alloc] init];
+    [visa setString:uid forKey:@"did"];
+    [visa setProperty:@(time) forKey:@"time"];
+    [visa setPublicKey:visaKey];
+    [visa sign:idKey];
+    return visa;
+}
+
+@interface DIMCommonPackerTests : XCTestCase {
+
+    __MemoryDatabase *_database;
+    DIMClientFacebook *_facebook;
+    DIMClientArchivist *_archivist;
+    DIMCommonPacker *_packer;
+
+    // the private keys for signing visa
+    NSMutableDictionary<NSString *, id<MKSignKey>> *_idKeys;
+}
+
+@end
+
+@implementation DIMCommonPackerTests
+
+- (void)setUp {
+    [DIMClientFacebook prepare];
+    _database = [[__MemoryDatabase alloc] init];
+    _facebook = [[DIMClientFacebook alloc] initWithDatabase:_database];
+    _archivist = [[DIMClientArchivist alloc] initWithFacebook:_facebook database:_database];
+    [_facebook setArchivist:_archivist];
+    DIMMessenger *messenger = nil;
+    _packer = [[DIMCommonPacker alloc] initWithFacebook:_facebook messenger:messenger];
+    _idKeys = [[NSMutableDictionary alloc] init];
+}
+
+// users with their own meta, all visas share one encrypt key
+// (RSA keys are too slow to generate for each one)
+- (NSArray<id<MKMID>> *)createUsers:(NSUInteger)count
+                         withVisaKey:(id<MKEncryptKey>)visaKey {
+    NSMutableArray<id<MKMID>> *users = [[NSMutableArray alloc] initWithCapacity:count];
+    NSTimeInterval now = OKGetCurrentTimeInterval();
+    id<MKPrivateKey> idKey;
+    id<MKMMeta> meta;
+    id<MKMID> uid;
+    for (NSUInteger index = 0; index < count; ++index) {
+        idKey = MKPrivateKeyGenerate(MKAsymmetricAlgorithm_ECC);
+        meta = MKMMetaGenerate(MKMMetaType_ETH, idKey, nil);
+        uid = MKMIDGenerate(meta, MKMEntityType_User, nil);
+        [_database saveMeta:meta forID:uid];
+        [_database saveDocument:create_visa(uid, visaKey, idKey, now) forID:uid];
+        [_idKeys setObject:idKey forKey:uid.string];
+        [users addObject:uid];
+    }
+    return users;
+}
+
+- (id<MKEncryptKey>)createVisaKey {
+    id<MKPrivateKey> msgKey = MKPrivateKeyGenerate(MKAsymmetricAlgorithm_RSA);
+    return (id<MKEncryptKey>)[msgKey publicKey];
+}
+
+- (void)testRebuildKeyForNewerVisa {
+    id<MKEncryptKey> oldKey = [self createVisaKey];
+    id<MKMID> uid = [[self createUsers:1 withVisaKey:oldKey] firstObject];
+
+    id<MKEncryptKey> key = [_packer messageKey:uid];
+    XCTAssertEqualObjects(key, oldKey);
+    // cached
+    XCTAssertTrue([_packer messageKey:uid] == key);
+
+    // the archivist accepts a newer visa with another key
+    id<MKEncryptKey> newKey = [self createVisaKey];
+    id<MKSignKey> idKey = [_idKeys objectForKey:uid.string];
+    NSTimeInterval later = OKGetCurrentTimeInterval() + 60;
+    XCTAssertTrue([_archivist saveDocument:create_visa(uid, newKey, idKey, later) forID:uid]);
+
+    key = [_packer messageKey:uid];
+    XCTAssertEqualObjects(key, newKey);
+    XCTAssertNotEqualObjects(key, oldKey);
+    // cached again
+    XCTAssertTrue([_packer messageKey:uid] == key);
+}
+
+// 100k sends to 1k contacts: compare the numbers of these two
+
+- (void)testPerformanceCachedMessageKey {
+    NSArray<id<MKMID>> *contacts = [self createUsers:CONTACTS withVisaKey:[self createVisaKey]];
+    [self measureBlock:^{
+        for (NSUInteger index = 0; index < SENDS; ++index) {
+            [self->_packer messageKey:[contacts objectAtIndex:(index % CONTACTS)]];
+        }
+    }];
+}
+
+- (void)testPerformanceVisaPublicKey {
+    NSArray<id<MKMID>> *contacts = [self createUsers:CONTACTS withVisaKey:[self createVisaKey]];
+    [self measureBlock:^{
+        for (NSUInteger index = 0; index < SENDS; ++index) {
+            // building the key from the visa every time, as before
+            [[self->_facebook visaForID:[contacts objectAtIndex:(index % CONTACTS)]] publicKey];
+        }
+    }];
+}
+
+@end
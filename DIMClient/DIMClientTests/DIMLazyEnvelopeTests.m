@@ -0,0 +1,99 @@
+//
+//  DIMLazyEnvelopeTests.m
+//  DIMClientTests
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import <XCTest/XCTest.h>
+
+#import <DIMClient/DIMClient.h>
+
+#define SENDER   "moky@4DnqXWdTV8wuZgfqSCX9GjE2kNq7HJrUgQ"
+#define RECEIVER "hulk@4YeVEN3aUnvC1DNUufCq1bs9zoBSJTzVEj"
+
+static inline DIMLazyEnvelope *scan(NSString *json) {
+    return [DIMLazyEnvelope envelopeWithData:MKUTF8Encode(json)];
+}
+
+@interface DIMLazyEnvelopeTests : XCTestCase
+
+@end
+
+@implementation DIMLazyEnvelopeTests
+
+- (void)setUp {
+    [DIMClientFacebook prepare];
+}
+
+- (void)testPlainEnvelope {
+    NSDictionary *info = @{
+        @"sender": @"" SENDER,
+        @"receiver": @"" RECEIVER,
+        @"sn": @(3344),
+        @"time": @(1700000000.5),
+        @"data": @"AAAA",
+        @"signature": @"SIG",
+    };
+    NSData *data = [NSJSONSerialization dataWithJSONObject:info options:0 error:nil];
+    DIMLazyEnvelope *env = [DIMLazyEnvelope envelopeWithData:data];
+    XCTAssertNotNil(env);
+    XCTAssertEqualObjects(env.sender, @"" SENDER);
+    XCTAssertEqualObjects(env.receiver, @"" RECEIVER);
+    XCTAssertEqualObjects(env.signature, @"SIG");
+    XCTAssertEqualObjects(env.sn, @(3344));
+    XCTAssertEqualObjects(env.senderID, MKMIDParse(@"" SENDER));
+    XCTAssertEqualObjects(env.receiverID, MKMIDParse(@"" RECEIVER));
+    XCTAssertNil(env.group);
+}
+
+- (void)testEscapedStrings {
+    // escaped quote, slash and backslash in the values scanned and skipped
+    NSString *json = @"{\"data\":\"ab\\\"c\\\\\", \"sender\":\"" SENDER "\","
+                      "\"receiver\":\"" RECEIVER "\", \"signature\":\"a\\/b+c\\u003d\"}";
+    DIMLazyEnvelope *env = scan(json);
+    XCTAssertNotNil(env);
+    XCTAssertEqualObjects(env.sender, @"" SENDER);
+    XCTAssertEqualObjects(env.receiver, @"" RECEIVER);
+    XCTAssertEqualObjects(env.signature, @"a/b+c=");
+}
+
+- (void)testNestedValues {
+    // brackets & quotes inside nested values must not end them
+    NSString *json = @"{\"meta\":{\"key\":{\"data\":\"}]\\\"{[\"},\"list\":[1,[2,{\"x\":\"]\"}],{}]},"
+                      "\"keys\":[],\"sender\":\"" SENDER "\",\"receiver\":\"" RECEIVER "\","
+                      "\"group\":\"" RECEIVER "\",\"sn\":-12}";
+    DIMLazyEnvelope *env = scan(json);
+    XCTAssertNotNil(env);
+    XCTAssertEqualObjects(env.sender, @"" SENDER);
+    XCTAssertEqualObjects(env.receiver, @"" RECEIVER);
+    XCTAssertEqualObjects(env.group, @"" RECEIVER);
+    XCTAssertEqualObjects(env.sn, @(-12));
+}
+
+- (void)testTrailingLiterals {
+    // literals & numbers ending with '}' or spaces
+    NSString *json = @"{ \"sender\" : \"" SENDER "\" , \"receiver\":\"" RECEIVER "\" ,"
+                      "\"time\":1.7e9, \"muted\":true, \"group\":null, \"sn\":42\n}";
+    DIMLazyEnvelope *env = scan(json);
+    XCTAssertNotNil(env);
+    XCTAssertEqualObjects(env.receiver, @"" RECEIVER);
+    XCTAssertNil(env.group);
+    XCTAssertEqualObjects(env.sn, @(42));
+
+    json = @"{\"sender\":\"" SENDER "\",\"receiver\":\"" RECEIVER "\",\"read\":false}";
+    XCTAssertNotNil(scan(json));
+}
+
+- (void)testBrokenPackages {
+    // not an object
+    XCTAssertNil(scan(@"[\"" SENDER "\"]"));
+    // receiver not found
+    XCTAssertNil(scan(@"{\"sender\":\"" SENDER "\",\"data\":\"AAAA\"}"));
+    // unterminated string
+    XCTAssertNil(scan(@"{\"sender\":\"" SENDER "\",\"receiver\":\"hulk"));
+    // unterminated nested value
+    XCTAssertNil(scan(@"{\"sender\":\"" SENDER "\",\"receiver\":\"" RECEIVER "\",\"meta\":{\"a\":[1,2}"));
+}
+
+@end
@@ -0,0 +1,165 @@
+//
+//  DIMMessageQueueTests.m
+//  DIMClientTests
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import <XCTest/XCTest.h>
+#import <stdatomic.h>
+
+#import <DIMClient/DIMClient.h>
+
+#define PRODUCERS  8
+#define MESSAGES   2000  // for each producer
+
+#define BENCH_MESSAGES    100000
+#define BENCH_PRIORITIES  5
+
+static inline id<DKDReliableMessage> create_message(NSUInteger index) {
+    return DKDReliableMessageParse(@{
+        @"sender": @"moky@4DnqXWdTV8wuZgfqSCX9GjE2kNq7HJrUgQ",
+        @"receiver": @"hulk@4YeVEN3aUnvC1DNUufCq1bs9zoBSJTzVEj",
+        @"time": @(1700000000 + index),
+        @"data": @"AAAA",
+        @"signature": [NSString stringWithFormat:@"sig-%lu", index],
+    });
+}
+
+static inline id<STDeparture> create_ship(NSUInteger index) {
+    NSData *pack = MKUTF8Encode([NSString stringWithFormat:@"{\"sn\":%lu}", index]);
+    NSInteger prior = (index % 3 == 0) ? STDeparturePriorityUrgent : STDeparturePriorityNormal;
+    return [[STPlainDeparture alloc] initWithData:pack priority:prior];
+}
+
+@interface DIMMessageQueueTests : XCTestCase
+
+@end
+
+@implementation DIMMessageQueueTests
+
+- (void)setUp {
+    [DIMClientFacebook prepare];
+}
+
+// push the same messages twice from all producers
+- (NSUInteger)fillQueue:(DIMMessageQueue *)queue {
+    _Atomic(NSUInteger) appended = 0;
+    _Atomic(NSUInteger) *counter = &appended;
+    dispatch_apply(PRODUCERS, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t p) {
+        NSUInteger index;
+        for (NSUInteger round = 0; round < 2; ++round) {
+            for (NSUInteger i = 0; i < MESSAGES; ++i) {
+                index = p * MESSAGES + i;
+                if ([queue appendReliableMessage:create_message(index)
+                                   departureShip:create_ship(index)]) {
+                    atomic_fetch_add(counter, 1);
+                }
+            }
+        }
+    });
+    return atomic_load(&appended);
+}
+
+- (void)testConcurrentAppendRejectsDuplicates {
+    DIMConcurrentMessageQueue *queue = [[DIMConcurrentMessageQueue alloc] initWithCapacity:256];
+    NSUInteger appended = [self fillQueue:queue];
+    XCTAssertEqual(appended, PRODUCERS * MESSAGES);
+    XCTAssertEqual([queue count], PRODUCERS * MESSAGES);
+    // small rings must overflow into the locked path without losing messages
+    XCTAssertGreaterThan([queue overflowCount], 0);
+
+    NSMutableSet *keys = [[NSMutableSet alloc] init];
+    DIMMessageWrapper *wrapper;
+    while ((wrapper = [queue nextTask])) {
+        [keys addObject:[DIMMessageQueue keyForMessage:[wrapper message]]];
+    }
+    XCTAssertEqual([keys count], PRODUCERS * MESSAGES);
+    XCTAssertEqual([queue count], 0);
+}
+
+- (void)testConcurrentAppendWhileConsuming {
+    DIMConcurrentMessageQueue *queue = [[DIMConcurrentMessageQueue alloc] init];
+    atomic_bool done = false;
+    atomic_bool *flag = &done;
+    __block NSUInteger taken = 0;
+    dispatch_semaphore_t finished = dispatch_semaphore_create(0);
+    // single consumer, like the gate thread
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        while (!atomic_load(flag) || [queue count] > 0) {
+            if ([queue nextTask]) {
+                ++taken;
+            }
+        }
+        dispatch_semaphore_signal(finished);
+    });
+    NSUInteger appended = [self fillQueue:queue];
+    atomic_store(&done, true);
+    dispatch_semaphore_wait(finished, DISPATCH_TIME_FOREVER);
+    // a message can be appended again after it was taken
+    XCTAssertGreaterThanOrEqual(appended, PRODUCERS * MESSAGES);
+    XCTAssertEqual(taken, appended);
+}
+
+- (void)testOverflowKeepsOrder {
+    DIMConcurrentMessageQueue *queue = [[DIMConcurrentMessageQueue alloc] initWithCapacity:4];
+    NSData *pack;
+    for (NSUInteger index = 0; index < 100; ++index) {
+        pack = MKUTF8Encode([NSString stringWithFormat:@"%lu", index]);
+        XCTAssertTrue([queue appendReliableMessage:create_message(index)
+                                     departureShip:[[STPlainDeparture alloc] initWithData:pack
+                                                                                 priority:0]]);
+    }
+    NSString *expected;
+    for (NSUInteger index = 0; index < 100; ++index) {
+        expected = [NSString stringWithFormat:@"sig-%lu", index];
+        XCTAssertEqualObjects([[[queue nextTask] message] objectForKey:@"signature"], expected);
+    }
+}
+
+// enqueue & drain 100k wrappers over 5 priorities on one thread
+- (void)testPerformanceEnqueueAndDrain {
+    NSMutableArray *messages = [[NSMutableArray alloc] initWithCapacity:BENCH_MESSAGES];
+    NSMutableArray *ships = [[NSMutableArray alloc] initWithCapacity:BENCH_MESSAGES];
+    NSData *pack;
+    for (NSUInteger index = 0; index < BENCH_MESSAGES; ++index) {
+        pack = MKUTF8Encode([NSString stringWithFormat:@"{\"sn\":%lu}", index]);
+        [messages addObject:create_message(index)];
+        [ships addObject:[[STPlainDeparture alloc] initWithData:pack
+                                                       priority:(index % BENCH_PRIORITIES)]];
+    }
+    [self measureBlock:^{
+        DIMMessageQueue *queue = [DIMMessageQueue queue];
+        for (NSUInteger index = 0; index < BENCH_MESSAGES; ++index) {
+            [queue appendReliableMessage:[messages objectAtIndex:index]
+                           departureShip:[ships objectAtIndex:index]];
+        }
+        XCTAssertEqual([queue count], BENCH_MESSAGES);
+        // drained from the highest priority (smallest value) first
+        NSInteger last = NSIntegerMin;
+        NSUInteger count = 0;
+        DIMMessageWrapper *wrapper;
+        while ((wrapper = [queue nextTask])) {
+            XCTAssertGreaterThanOrEqual([wrapper priority], last);
+            last = [wrapper priority];
+            ++count;
+        }
+        XCTAssertEqual(count, BENCH_MESSAGES);
+        [queue purge];
+    }];
+}
+
+// contention: compare the numbers of these two
+- (void)testPerformanceLockedQueue {
+    [self measureBlock:^{
+        [self fillQueue:[DIMMessageQueue queue]];
+    }];
+}
+
+- (void)testPerformanceConcurrentQueue {
+    [self measureBlock:^{
+        [self fillQueue:[[DIMConcurrentMessageQueue alloc] initWithCapacity:(PRODUCERS * MESSAGES)]];
+    }];
+}
+
+@end
@@ -0,0 +1,130 @@
+//
+//  DIMOutboxJournalTests.m
+//  DIMClientTests
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import <XCTest/XCTest.h>
+
+#import <DIMClient/DIMClient.h>
+
+static inline NSData *create_package(NSUInteger index) {
+    return MKUTF8Encode([NSString stringWithFormat:@"{\"sn\":%lu,\"data\":\"package-%lu\"}", index, index]);
+}
+
+static inline NSString *create_key(NSUInteger index) {
+    return [NSString stringWithFormat:@"key-%lu", index];
+}
+
+@interface DIMOutboxJournalTests : XCTestCase {
+
+    NSString *_path;
+}
+
+@end
+
+@implementation DIMOutboxJournalTests
+
+- (void)setUp {
+    NSString *name = [NSString stringWithFormat:@"journal-%@", [[NSUUID UUID] UUIDString]];
+    _path = [NSTemporaryDirectory() stringByAppendingPathComponent:name];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:_path error:nil];
+}
+
+- (NSArray<NSString *> *)replayKeys:(DIMOutboxJournal *)journal {
+    NSMutableArray *keys = [[NSMutableArray alloc] init];
+    [journal replay:^(NSString *key, NSData *package, NSInteger priority) {
+        [keys addObject:key];
+    }];
+    return keys;
+}
+
+- (void)testReplayAfterReopen {
+    DIMOutboxJournal *journal = [[DIMOutboxJournal alloc] initWithPath:_path];
+    for (NSUInteger index = 0; index < 3; ++index) {
+        XCTAssertTrue([journal appendPackage:create_package(index) priority:index forKey:create_key(index)]);
+    }
+    [journal removePackageForKey:create_key(1)];
+    [journal close];
+
+    journal = [[DIMOutboxJournal alloc] initWithPath:_path];
+    XCTAssertEqual([journal count], 2);
+    __block NSUInteger count = 0;
+    [journal replay:^(NSString *key, NSData *package, NSInteger priority) {
+        NSUInteger index = count == 0 ? 0 : 2;
+        XCTAssertEqualObjects(key, create_key(index));
+        XCTAssertEqualObjects(package, create_package(index));
+        XCTAssertEqual(priority, (NSInteger)index);
+        ++count;
+    }];
+    XCTAssertEqual(count, 2);
+}
+
+- (void)testTornTail {
+    DIMOutboxJournal *journal = [[DIMOutboxJournal alloc] initWithPath:_path];
+    for (NSUInteger index = 0; index < 3; ++index) {
+        [journal appendPackage:create_package(index) priority:0 forKey:create_key(index)];
+    }
+    [journal close];
+
+    // break the last record, as the app killed while writing it
+    NSMutableData *data = [[NSMutableData alloc] initWithContentsOfFile:_path];
+    NSRange range = [data rangeOfData:create_package(2) options:0 range:NSMakeRange(0, [data length])];
+    XCTAssertNotEqual(range.location, NSNotFound);
+    UInt8 *bytes = [data mutableBytes];
+    bytes[range.location + range.length - 1] ^= 0xFF;
+    XCTAssertTrue([data writeToFile:_path atomically:NO]);
+
+    journal = [[DIMOutboxJournal alloc] initWithPath:_path];
+    XCTAssertEqual([journal count], 2);
+    NSArray *expected = @[create_key(0), create_key(1)];
+    XCTAssertEqualObjects([self replayKeys:journal], expected);
+
+    // new records overwrite the torn tail
+    [journal appendPackage:create_package(3) priority:0 forKey:create_key(3)];
+    [journal close];
+    journal = [[DIMOutboxJournal alloc] initWithPath:_path];
+    expected = @[create_key(0), create_key(1), create_key(3)];
+    XCTAssertEqualObjects([self replayKeys:journal], expected);
+}
+
+- (void)testCompaction {
+    DIMOutboxJournal *journal = [[DIMOutboxJournal alloc] initWithPath:_path];
+    NSUInteger total = 1000;
+    for (NSUInteger index = 0; index < total; ++index) {
+        [journal appendPackage:create_package(index) priority:0 forKey:create_key(index)];
+    }
+    // overwrite the even ones, and remove most of them
+    for (NSUInteger index = 0; index < total; index += 2) {
+        [journal appendPackage:create_package(index) priority:1 forKey:create_key(index)];
+    }
+    NSMutableArray *expected = [[NSMutableArray alloc] init];
+    for (NSUInteger index = 0; index < total; ++index) {
+        if (index % 10 == 0) {
+            [expected addObject:create_key(index)];
+        } else {
+            [journal removePackageForKey:create_key(index)];
+        }
+    }
+    [journal flush];
+    [journal compact];
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:[_path stringByAppendingString:@".tmp"]]);
+    XCTAssertEqual([journal count], [expected count]);
+    XCTAssertEqualObjects([self replayKeys:journal], expected);
+
+    // keep working after compacted
+    [journal appendPackage:create_package(total) priority:0 forKey:create_key(total)];
+    [journal removePackageForKey:create_key(0)];
+    [journal close];
+
+    journal = [[DIMOutboxJournal alloc] initWithPath:_path];
+    [expected removeObject:create_key(0)];
+    [expected addObject:create_key(total)];
+    XCTAssertEqualObjects([self replayKeys:journal], expected);
+}
+
+@end
@@ -0,0 +1,179 @@
+//
+//  STSocketOptionsTests.m
+//  DIMClientTests
+//
+//  Created by agent on 2026/10/17.
+//
+
+#import <XCTest/XCTest.h>
+#import <sys/socket.h>
+#import <netinet/in.h>
+#import <arpa/inet.h>
+#import <unistd.h>
+
+#import <DIMClient/DIMClient.h>
+
+#define BULK_BYTES   (32 << 20)  // 32 MB for throughput
+#define BULK_CHUNK   (64 << 10)
+#define ECHO_ROUNDS  2000        // small request/response for latency
+#define ECHO_SIZE    256         // about the size of a small message
+
+// create a connected TCP pair over loopback: fds[0] = client, fds[1] = server
+static BOOL create_loopback(int fds[2]) {
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) {
+        return NO;
+    }
+    BOOL ok = bind(listener, (struct sockaddr *)&addr, len) == 0 &&
+              listen(listener, 1) == 0 &&
+              getsockname(listener, (struct sockaddr *)&addr, &len) == 0;
+    fds[0] = ok ? socket(AF_INET, SOCK_STREAM, 0) : -1;
+    ok = fds[0] >= 0 && connect(fds[0], (struct sockaddr *)&addr, len) == 0;
+    fds[1] = ok ? accept(listener, NULL, NULL) : -1;
+    close(listener);
+    return fds[1] >= 0;
+}
+
+static BOOL write_all(int fd, const uint8_t *buf, size_t len) {
+    ssize_t n;
+    while (len > 0) {
+        n = write(fd, buf, len);
+        if (n <= 0) {
+            return NO;
+        }
+        buf += n;
+        len -= n;
+    }
+    return YES;
+}
+
+static BOOL read_all(int fd, uint8_t *buf, size_t len) {
+    ssize_t n;
+    while (len > 0) {
+        n = read(fd, buf, len);
+        if (n <= 0) {
+            return NO;
+        }
+        buf += n;
+        len -= n;
+    }
+    return YES;
+}
+
+@interface STSocketOptionsTests : XCTestCase
+
+@end
+
+@implementation STSocketOptionsTests
+
+// profiles to compare, nil means the system defaults
+- (NSDictionary<NSString *, id> *)profiles {
+    STSocketOptions *small = [[STSocketOptions alloc] init];
+    small.sendBufferSize = 8 << 10;
+    small.receiveBufferSize = 8 << 10;
+    return @{
+        @"system": [NSNull null],
+        @"default": [STSocketOptions defaultOptions],
+        @"small-buffer": small,
+    };
+}
+
+- (void)testApplyToSocket {
+    int fds[2];
+    XCTAssertTrue(create_loopback(fds));
+    STSocketOptions *options = [STSocketOptions defaultOptions];
+    STSocketOptions *applied = [options applyToSocket:fds[0]];
+    XCTAssertNotNil(applied);
+    XCTAssertTrue(applied.noDelay);
+    XCTAssertTrue(applied.keepAlive);
+    // the kernel may double or clamp the buffer sizes
+    XCTAssertGreaterThan(applied.sendBufferSize, 0);
+    XCTAssertGreaterThan(applied.receiveBufferSize, 0);
+    // invalid handle
+    XCTAssertNil([options applyToSocket:-1]);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+- (void)testLoopbackProfiles {
+    NSDictionary *profiles = [self profiles];
+    for (NSString *name in profiles) {
+        id options = [profiles objectForKey:name];
+        int fds[2];
+        XCTAssertTrue(create_loopback(fds));
+        if ([options isKindOfClass:[STSocketOptions class]]) {
+            XCTAssertNotNil([options applyToSocket:fds[0]]);
+            XCTAssertNotNil([options applyToSocket:fds[1]]);
+        }
+        double mbps = [self throughputWithSocket:fds[0] peer:fds[1]];
+        double p99 = [self latencyWithSocket:fds[0] peer:fds[1]];
+        NSLog(@"[SOCKET] profile %@: throughput %.1f MB/s, p99 latency %.1f us", name, mbps, p99);
+        XCTAssertGreaterThan(mbps, 0);
+        XCTAssertGreaterThan(p99, 0);
+        close(fds[0]);
+        close(fds[1]);
+    }
+}
+
+// bulk transfer from client to server, in MB/s
+- (double)throughputWithSocket:(int)client peer:(int)server {
+    dispatch_semaphore_t done = dispatch_semaphore_create(0);
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        uint8_t *buf = malloc(BULK_CHUNK);
+        size_t left = BULK_BYTES;
+        ssize_t n;
+        while (left > 0 && (n = read(server, buf, MIN(left, BULK_CHUNK))) > 0) {
+            left -= n;
+        }
+        free(buf);
+        dispatch_semaphore_signal(done);
+    });
+    uint8_t *chunk = calloc(1, BULK_CHUNK);
+    NSTimeInterval start = OKGetCurrentTimeInterval();
+    for (size_t sent = 0; sent < BULK_BYTES; sent += BULK_CHUNK) {
+        if (!write_all(client, chunk, BULK_CHUNK)) {
+            break;
+        }
+    }
+    dispatch_semaphore_wait(done, DISPATCH_TIME_FOREVER);
+    NSTimeInterval elapsed = OKGetCurrentTimeInterval() - start;
+    free(chunk);
+    return elapsed > 0 ? BULK_BYTES / elapsed / (1 << 20) : 0;
+}
+
+// request/echo round trips, p99 in microseconds
+- (double)latencyWithSocket:(int)client peer:(int)server {
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        uint8_t buf[ECHO_SIZE];
+        for (NSUInteger i = 0; i < ECHO_ROUNDS; ++i) {
+            if (!read_all(server, buf, ECHO_SIZE) || !write_all(server, buf, ECHO_SIZE)) {
+                break;
+            }
+        }
+    });
+    uint8_t buf[ECHO_SIZE] = {0};
+    double *samples = malloc(sizeof(double) * ECHO_ROUNDS);
+    NSUInteger count = 0;
+    NSTimeInterval start;
+    for (; count < ECHO_ROUNDS; ++count) {
+        start = OKGetCurrentTimeInterval();
+        if (!write_all(client, buf, ECHO_SIZE) || !read_all(client, buf, ECHO_SIZE)) {
+            break;
+        }
+        samples[count] = (OKGetCurrentTimeInterval() - start) * 1000000;
+    }
+    qsort_b(samples, count, sizeof(double), ^int(const void *a, const void *b) {
+        double x = *(const double *)a, y = *(const double *)b;
+        return x < y ? -1 : (x > y ? 1 : 0);
+    });
+    double p99 = count > 0 ? samples[count * 99 / 100] : 0;
+    free(samples);
+    return p99;
+}
+
+@end